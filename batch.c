@@ -0,0 +1,375 @@
+// The batch builtin: runs a command on many input items with as few execs as possible
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+extern char** environ;
+
+
+/*
+* Settings and progress of one batch command
+*/
+struct Batch {
+    char** fixedArgv;  // command and the args given with it, copied ahead of each batch's items
+    int fixedArgCount;
+    long argSpace;  // bytes left for items in each exec, after the fixed args and environment
+    int maxItems;  // most items per exec (-n), or 0 for no limit besides argSpace
+    int maxRunning;  // most execs running at once (-P)
+
+    // items collected for the next exec
+    char** items;
+    int itemCount;
+    int itemCapacity;
+    long itemSpace;  // bytes the collected items take up as exec args
+
+    // execs still running
+    pid_t runningPids[MAX_BATCH_PARALLEL];
+    struct timespec runningStartTimes[MAX_BATCH_PARALLEL];
+    int runningCount;
+
+    bool hasFailed;  // true once any exec has failed
+};
+
+
+/*
+* Gets the number of bytes an exec arg takes up against the kernel's ARG_MAX limit
+* arg: the arg
+* return: its length, null terminator, and pointer in argv
+*/
+static long getArgSize(const char* arg) {
+    return strlen(arg) + 1 + sizeof(char*);
+}
+
+
+/*
+* Works out how many bytes of args each exec can be given
+* The kernel's limit (sysconf(_SC_ARG_MAX)) covers the environment as well as argv,
+* so the environment's size is taken off, along with some headroom like xargs keeps
+* return: bytes available for the whole argv
+*/
+static long getArgSpace() {
+    long argMax = sysconf(_SC_ARG_MAX);
+
+    // sysconf() can fail or report no limit; fall back to the smallest limit POSIX allows
+    if (argMax <= 0) {
+        argMax = _POSIX_ARG_MAX;
+    }
+
+    // the environment is passed to every exec too
+    for (char** variable = environ; *variable; ++variable) {
+        argMax -= getArgSize(*variable);
+    }
+
+    return argMax - BATCH_ARG_HEADROOM;
+}
+
+
+/*
+* Waits for one of the batch's execs to end, without busy-waiting
+* The exec that ends first is waited for, using pidfds, so a slow one doesn't hold up
+* the next batch. Without pidfds, the oldest exec is waited for instead
+* batch: the batch command
+* return: nothing, but the ended exec is removed from batch->runningPids
+*/
+static void waitForBatchExec(struct Batch* batch) {
+    struct pollfd pollFDs[MAX_BATCH_PARALLEL + 1] = {{.fd = -1}};  // a pidfd per exec, then the timerfd
+    int endedIndex = 0;  // the oldest, if pidfds aren't supported
+    int childStatus;
+    pid_t childPid;
+
+    // with nothing running, waitpid() below would wait for any child instead
+    if (batch->runningCount == 0) {
+        return;
+    }
+
+    // open a pidfd per exec
+    for (int index = 0; index < batch->runningCount; ++index) {
+        pollFDs[index].fd = openPidfd(batch->runningPids[index]);
+        pollFDs[index].events = POLLIN;
+    }
+
+    // Sleep until one ends, running scheduled commands as they come due (without pidfds,
+    // they wait until the oldest exec ends). Ctrl+C ends the execs too, so EINTR just means poll again
+    if (pollFDs[0].fd != -1) {
+        int timerIndex = batch->runningCount;
+        bool hasEnded = false;
+
+        pollFDs[timerIndex].fd = getTimerFD();
+        pollFDs[timerIndex].events = POLLIN;
+
+        while (!hasEnded) {
+            if (poll(pollFDs, batch->runningCount + 1, -1) == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                break;
+            }
+
+            if (pollFDs[timerIndex].revents & POLLIN) {
+                runDueTimers();
+            }
+
+            for (int index = 0; index < batch->runningCount; ++index) {
+                if (pollFDs[index].revents & POLLIN) {
+                    endedIndex = index;
+                    hasEnded = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int index = 0; index < batch->runningCount; ++index) {
+        if (pollFDs[index].fd != -1) {
+            close(pollFDs[index].fd);
+        }
+    }
+
+    // reap it
+    childPid = batch->runningPids[endedIndex];
+
+    while (waitpid(childPid, &childStatus, 0) == -1 && errno == EINTR) {
+    }
+
+    if (WIFEXITED(childStatus)) {
+        logJobEvent(JOB_EXIT, childPid, WEXITSTATUS(childStatus), false,
+                    getElapsedNanoseconds(&batch->runningStartTimes[endedIndex]), NULL);
+        batch->hasFailed = batch->hasFailed || WEXITSTATUS(childStatus) != 0;
+    } else {
+        logJobEvent(JOB_SIGNAL, childPid, WTERMSIG(childStatus), false,
+                    getElapsedNanoseconds(&batch->runningStartTimes[endedIndex]), NULL);
+        batch->hasFailed = true;
+    }
+
+    // remove it from the running list, keeping the rest in start order
+    --batch->runningCount;
+    memmove(&batch->runningPids[endedIndex], &batch->runningPids[endedIndex + 1],
+            (batch->runningCount - endedIndex) * sizeof(pid_t));
+    memmove(&batch->runningStartTimes[endedIndex], &batch->runningStartTimes[endedIndex + 1],
+            (batch->runningCount - endedIndex) * sizeof(struct timespec));
+
+    return;
+}
+
+
+/*
+* Execs the command with the collected items, then clears them
+* If -P execs are already running, this first waits for one of them to end
+* batch: the batch command
+* commandLine: the batch command line, for the event log
+*/
+static void runBatch(struct Batch* batch, struct CommandLine* commandLine) {
+    if (batch->itemCount == 0) {
+        return;
+    }
+
+    // wait for room to run another exec
+    while (batch->runningCount >= batch->maxRunning) {
+        waitForBatchExec(batch);
+    }
+
+    pid_t spawnPid = fork();
+
+    switch (spawnPid) {
+        case -1:
+            // fork() failed to create a child process
+            printToTerminal("fork() failed to create a child process\n", true);
+            batch->hasFailed = true;
+            break;
+
+        case 0:
+            // Only the child process will execute this. It's a foreground child, so
+            // SIGINT shouldn't be blocked, but SIGTSTP should
+            setSIGTSTPhandler(true);
+            resetSIGINThandler();
+
+            // the items come from stdin, so the command mustn't read them too
+            // (_exit() leaves the stdin stream alone, unlike exit(), which would seek a
+            // script smallsh is reading back to where the child's copy had read up to)
+            if (redirectStdin(NULL) == -1) {
+                _exit(1);
+            }
+
+            // argv is the fixed args followed by the items
+            char** childArgv = calloc(batch->fixedArgCount + batch->itemCount + 1, sizeof(char*));
+            memcpy(childArgv, batch->fixedArgv, batch->fixedArgCount * sizeof(char*));
+            memcpy(childArgv + batch->fixedArgCount, batch->items, batch->itemCount * sizeof(char*));
+
+            execvp(childArgv[0], childArgv);
+
+            // This code will only be executed if exec returns because of an error
+            printToTerminal(childArgv[0], true);
+            _exit(EXIT_FAILURE + 1);
+            break;
+
+        default:
+            // Only the parent process (smallsh) will execute this
+            logJobEvent(JOB_SPAWN, spawnPid, 0, false, 0, commandLine);
+            batch->runningPids[batch->runningCount] = spawnPid;
+            clock_gettime(CLOCK_MONOTONIC, &batch->runningStartTimes[batch->runningCount]);
+            ++batch->runningCount;
+            break;
+    }
+
+    // the child has its own copy of the items
+    for (int index = 0; index < batch->itemCount; ++index) {
+        free(batch->items[index]);
+    }
+
+    batch->itemCount = 0;
+    batch->itemSpace = 0;
+
+    return;
+}
+
+
+/*
+* Adds an input item to the next exec, running the collected items first
+* if the item wouldn't fit in the same exec
+* batch: the batch command
+* item: the item, which the batch takes ownership of
+* commandLine: the batch command line, for the event log
+*/
+static void addBatchItem(struct Batch* batch, char* item, struct CommandLine* commandLine) {
+    long itemSize = getArgSize(item);
+
+    // an item that can't fit in any exec would make execvp() fail with E2BIG. Besides
+    // the limit on all args together, the kernel limits each arg on its own
+    if (itemSize > batch->argSpace || (long) strlen(item) + 1 > MAX_EXEC_ARG_LENGTH) {
+        fprintf(stderr, "batch: item is too long for one command line: %.40s...\n", item);
+        fflush(stderr);
+        batch->hasFailed = true;
+        free(item);
+        return;
+    }
+
+    // start a new exec if this item would go over either limit
+    if (batch->itemSpace + itemSize > batch->argSpace
+            || (batch->maxItems > 0 && batch->itemCount >= batch->maxItems)) {
+        runBatch(batch, commandLine);
+    }
+
+    // make room for the item
+    if (batch->itemCount == batch->itemCapacity) {
+        batch->itemCapacity = batch->itemCapacity ? batch->itemCapacity * 2 : 256;
+        batch->items = realloc(batch->items, batch->itemCapacity * sizeof(char*));
+    }
+
+    batch->items[batch->itemCount] = item;
+    ++batch->itemCount;
+    batch->itemSpace += itemSize;
+
+    return;
+}
+
+
+/*
+* Runs a command on input items, packing as many items into each exec as the kernel
+* allows, like xargs
+* batch [-P n] [-n max] command [arg...]
+* Items are read from stdin, one per line (so they may contain spaces), and appended
+* to the args. Each exec gets as many items as fit in sysconf(_SC_ARG_MAX), less the
+* environment, or at most max items with -n. With -P, up to n execs run at once
+* (-P 0 runs one per CPU). The execs get /dev/null as stdin.
+* The status command reports 0 if every exec succeeded, or 123 (like xargs) if not
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleBatchCommand(struct CommandLine* commandLine) {
+    struct Batch batch = {0};
+    int argIndex = 0;
+    FILE* itemStream = NULL;  // NULL if the items are smallsh's own input
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t lineLength;
+
+    batch.maxRunning = 1;
+
+    // read the options
+    while (argIndex + 1 < commandLine->argCount && commandLine->args[argIndex][0] == '-') {
+        char* option = commandLine->args[argIndex];
+        int value = atoi(commandLine->args[argIndex + 1]);
+
+        if (isEqualString(option, "-P")) {
+            batch.maxRunning = value > 0 ? value : sysconf(_SC_NPROCESSORS_ONLN);
+        } else if (isEqualString(option, "-n")) {
+            batch.maxItems = value;
+        } else {
+            break;
+        }
+
+        argIndex += 2;
+    }
+
+    if (argIndex >= commandLine->argCount) {
+        printToTerminal("usage: batch [-P n] [-n max] command [arg...]\n", false);
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    // there's room to track only so many execs at once (and sysconf() may have failed)
+    if (batch.maxRunning > MAX_BATCH_PARALLEL) {
+        batch.maxRunning = MAX_BATCH_PARALLEL;
+    } else if (batch.maxRunning < 1) {
+        batch.maxRunning = 1;
+    }
+
+    // the command and its args go ahead of the items in every exec
+    batch.fixedArgv = &commandLine->args[argIndex];
+    batch.fixedArgCount = commandLine->argCount - argIndex;
+    batch.argSpace = getArgSpace() - sizeof(char*);  // for the argv's NULL
+
+    for (int index = 0; index < batch.fixedArgCount; ++index) {
+        batch.argSpace -= getArgSize(batch.fixedArgv[index]);
+    }
+
+    // If stdin was redirected for this builtin, it's read through a stream of its own.
+    // If not, the items are the lines after the command in smallsh's own input
+    if (commandLine->inFile || commandLine->hereDocument) {
+        itemStream = fdopen(fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 0), "r");
+    }
+
+    // collect the items, running execs as they fill up (ctrl+C stops reading them)
+    GLOBAL_receivedSIGINT = 0;
+
+    while (!GLOBAL_receivedSIGINT
+           && (lineLength = itemStream ? getline(&line, &lineCapacity, itemStream) : getInputLine(&line, &lineCapacity)) != -1) {
+        if (lineLength > 0 && line[lineLength - 1] == '\n') {
+            line[lineLength - 1] = '\0';
+            --lineLength;
+        }
+
+        // skip blank lines
+        if (lineLength > 0) {
+            addBatchItem(&batch, strdup(line), commandLine);
+        }
+    }
+
+    // run the remaining items, unless interrupted, then wait for every exec
+    if (GLOBAL_receivedSIGINT) {
+        for (int index = 0; index < batch.itemCount; ++index) {
+            free(batch.items[index]);
+        }
+
+        batch.itemCount = 0;
+        batch.hasFailed = true;
+    }
+
+    runBatch(&batch, commandLine);
+
+    while (batch.runningCount > 0) {
+        waitForBatchExec(&batch);
+    }
+
+    // update status
+    GLOBAL_lastForegroundChildStatus = batch.hasFailed ? 123 : 0;
+
+    if (itemStream) {
+        fclose(itemStream);
+    }
+
+    free(line);
+    free(batch.items);
+
+    return;
+}
@@ -0,0 +1,185 @@
+// Micro-benchmarks for the smallsh core
+// Each benchmark prints one line of JSON:
+//      {"benchmark":"name","iterations":n,"ns_per_op":x,"commit":"id"}
+// The commit id comes from $SMALLSH_BENCH_COMMIT (set by "make bench")
+#define _GNU_SOURCE
+#include "../smallsh.h"
+
+
+/*
+* Prints one benchmark result as a line of JSON
+* name: the benchmark's name
+* iterations: how many operations were timed
+* elapsedNanoseconds: how long they took in total
+*/
+void printBenchmarkResult(const char* name, long iterations, long long elapsedNanoseconds) {
+    char* commit = getenv("SMALLSH_BENCH_COMMIT");
+
+    printf("{\"benchmark\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.1f,\"commit\":\"%s\"}\n",
+           name, iterations, (double) elapsedNanoseconds / iterations, commit ? commit : "unknown");
+    fflush(NULL);
+
+    return;
+}
+
+
+/*
+* Times parseCommandString() on a typical command line with args, redirections, and &
+* Copying the line each time is included, because parsing modifies it
+*/
+void benchmarkParseCommandString(long iterations) {
+    const char* line = "ls -la /usr/bin /tmp --color=never < input_file > output_file 2> error_file &";
+    char buffer[MAX_INPUT_LENGTH];
+    struct timespec startTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (long iteration = 0; iteration < iterations; ++iteration) {
+        strcpy(buffer, line);
+        freeCommandLine(parseCommandString(buffer));
+    }
+
+    printBenchmarkResult("parseCommandString", iterations, getElapsedNanoseconds(&startTime));
+
+    return;
+}
+
+
+/*
+* Times parseCommandString() on a command line with the most args allowed
+*/
+void benchmarkParseLongCommandString(long iterations) {
+    char line[MAX_INPUT_LENGTH];
+    char buffer[MAX_INPUT_LENGTH];
+    struct timespec startTime;
+
+    // "echo" followed by as many 2-char args as fit
+    strcpy(line, "echo");
+    for (int argIndex = 0; argIndex < 500 && strlen(line) + 3 < MAX_INPUT_LENGTH; ++argIndex) {
+        strcat(line, " ab");
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (long iteration = 0; iteration < iterations; ++iteration) {
+        strcpy(buffer, line);
+        freeCommandLine(parseCommandString(buffer));
+    }
+
+    printBenchmarkResult("parseCommandString_500_args", iterations, getElapsedNanoseconds(&startTime));
+
+    return;
+}
+
+
+/*
+* Times expandPidVariable() on strings with and without $$ in them
+*/
+void benchmarkExpandPidVariable(long iterations) {
+    const char* lines[] = {
+        "ls -la /usr/bin /tmp --color=never > output_file",
+        "echo $$ > /tmp/smallsh_$$.out && cat /tmp/smallsh_$$.out $$$"
+    };
+    const char* names[] = {"expandPidVariable_none", "expandPidVariable_several"};
+    char buffer[MAX_INPUT_LENGTH];
+    struct timespec startTime;
+
+    for (int lineIndex = 0; lineIndex < 2; ++lineIndex) {
+        clock_gettime(CLOCK_MONOTONIC, &startTime);
+        for (long iteration = 0; iteration < iterations; ++iteration) {
+            strcpy(buffer, lines[lineIndex]);
+            free(expandPidVariable(buffer));
+        }
+
+        printBenchmarkResult(names[lineIndex], iterations, getElapsedNanoseconds(&startTime));
+    }
+
+    return;
+}
+
+
+/*
+* Times adding a pid to a full-but-one background job table and removing it again,
+* which is the worst case for the table's linear searches
+*/
+void benchmarkJobTable(long iterations) {
+    struct timespec startTime;
+
+    // fill all but the last slot with pids that can't be real
+    for (int index = 0; index < MAX_BG_CHILDREN - 1; ++index) {
+        GLOBAL_backgroundChildrenPids[index] = INT_MAX - index;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (long iteration = 0; iteration < iterations; ++iteration) {
+        registerNewBgChildPid(12345);
+        unregisterBgChildPid(12345);
+    }
+
+    printBenchmarkResult("registerNewBgChildPid_unregisterBgChildPid", iterations, getElapsedNanoseconds(&startTime));
+
+    memset(GLOBAL_backgroundChildrenPids, 0, sizeof(GLOBAL_backgroundChildrenPids));
+
+    return;
+}
+
+
+/*
+* Times reapAll() with an empty job table, and with a full table of jobs
+* that haven't finished yet
+*/
+void benchmarkReapAll(long iterations) {
+    struct timespec startTime;
+    pid_t sleeperPids[MAX_BG_CHILDREN];
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (long iteration = 0; iteration < iterations; ++iteration) {
+        reapAll();
+    }
+
+    printBenchmarkResult("reapAll_empty", iterations, getElapsedNanoseconds(&startTime));
+
+    // fill the table with real children that stay alive until they're killed
+    for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+        sleeperPids[index] = fork();
+
+        if (sleeperPids[index] == 0) {
+            pause();
+            _exit(EXIT_SUCCESS);
+        }
+
+        registerNewBgChildPid(sleeperPids[index]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (long iteration = 0; iteration < iterations; ++iteration) {
+        reapAll();
+    }
+
+    printBenchmarkResult("reapAll_full_table", iterations, getElapsedNanoseconds(&startTime));
+
+    // clean up the children without printing their notices
+    for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+        kill(sleeperPids[index], SIGKILL);
+        waitpid(sleeperPids[index], NULL, 0);
+        unregisterBgChildPid(sleeperPids[index]);
+    }
+
+    return;
+}
+
+
+/*
+* Runs the micro-benchmarks
+* An optional argument scales the number of iterations (default 1)
+*/
+int main(int argc, char* argv[]) {
+    long scale = argc > 1 ? atol(argv[1]) : 1;
+    scale = scale > 0 ? scale : 1;
+
+    benchmarkParseCommandString(200000 * scale);
+    benchmarkParseLongCommandString(2000 * scale);
+    benchmarkExpandPidVariable(200000 * scale);
+    benchmarkJobTable(1000000 * scale);
+    benchmarkReapAll(2000 * scale);
+
+    return EXIT_SUCCESS;
+}
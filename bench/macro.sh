@@ -0,0 +1,69 @@
+#!/bin/bash
+# Macro-benchmarks for smallsh
+# Each workload is a generated script that is piped into smallsh, timed from start to exit.
+# Each workload prints one line of JSON:
+#       {"benchmark":"name","iterations":n,"ns_per_op":x,"commit":"id"}
+# The commit id comes from $SMALLSH_BENCH_COMMIT (set by "make bench")
+# usage: bench/macro.sh [path to smallsh] [scale]
+
+SMALLSH=$(realpath "${1:-./smallsh}")
+SCALE=${2:-1}
+COMMIT=${SMALLSH_BENCH_COMMIT:-unknown}
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+# keep the benchmarks from reading or growing the user's history
+export SMALLSH_HISTFILE=/dev/null
+unset SMALLSH_EVENTLOG
+
+
+# runs a workload script through smallsh and prints its result
+# $1: benchmark name
+# $2: number of operations in the script
+# $3: script file
+run_workload() {
+    local start end
+    start=$(date +%s%N)
+    (cd "$WORK_DIR" && "$SMALLSH" < "$3" > /dev/null 2>&1)
+    end=$(date +%s%N)
+
+    awk -v name="$1" -v count="$2" -v elapsed=$((end - start)) -v commit="$COMMIT" \
+        'BEGIN { printf "{\"benchmark\":\"%s\",\"iterations\":%d,\"ns_per_op\":%.1f,\"commit\":\"%s\"}\n", name, count, elapsed / count, commit }'
+}
+
+
+# spawn latency: run "true" in the foreground many times
+count=$((1000 * SCALE))
+for ((i = 0; i < count; ++i)); do echo "true"; done > "$WORK_DIR/spawn.txt"
+echo "exit" >> "$WORK_DIR/spawn.txt"
+run_workload "spawn_true" "$count" "$WORK_DIR/spawn.txt"
+
+# background jobs: start jobs in rounds that stay under smallsh's limit of 100 running
+# at once, waiting for each round to be reaped before starting the next
+count=$((1000 * SCALE))
+for ((i = 0; i < count; ++i)); do
+    echo "true &"
+    if (((i + 1) % 50 == 0)); then echo "wait"; fi
+done > "$WORK_DIR/background.txt"
+echo "wait" >> "$WORK_DIR/background.txt"
+echo "exit" >> "$WORK_DIR/background.txt"
+run_workload "background_jobs" "$count" "$WORK_DIR/background.txt"
+
+# long arg lists: commands with as many args as a line allows
+count=$((200 * SCALE))
+long_line="echo"
+for ((i = 0; i < 500; ++i)); do long_line+=" ab"; done
+for ((i = 0; i < count; ++i)); do echo "$long_line"; done > "$WORK_DIR/long_args.txt"
+echo "exit" >> "$WORK_DIR/long_args.txt"
+run_workload "long_arg_lists" "$count" "$WORK_DIR/long_args.txt"
+
+# redirection-heavy: every command redirects one or more streams
+count=$((250 * SCALE))
+for ((i = 0; i < count; ++i)); do
+    echo "echo line $i > out"
+    echo "cat < out >> all"
+    echo "ls missing_file 2> errors"
+    echo "status &> status_out"
+done > "$WORK_DIR/redirection.txt"
+echo "exit" >> "$WORK_DIR/redirection.txt"
+run_workload "redirection_heavy" "$((count * 4))" "$WORK_DIR/redirection.txt"
@@ -0,0 +1,302 @@
+// The structured job event log and its background writer thread
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* One job lifecycle event, as stored in the event ring
+*/
+struct JobEvent {
+    enum JobEventType type;
+    pid_t pid;
+    int status;  // exit value or signal number
+    bool isBackground;
+    struct timespec time;  // when the event happened (wall clock)
+    long long durationNanoseconds;  // how long the job ran, for exit and signal events
+    char command[EVENT_COMMAND_LENGTH];  // the command line, for spawn events
+};
+
+
+/*
+* The job event log. The shell thread adds events to a lock-free ring (it is the
+* only producer), and a background thread (the only consumer) writes them out in batches
+* head and tail only ever increase; a slot's index is the count modulo the capacity
+* The writer sleeps on wakeFD once the ring is empty, and the shell only signals it then
+*/
+struct EventLog {
+    int fd;
+    int wakeFD;  // eventfd the writer thread waits on
+    pid_t ownerPid;  // the shell process; forked children must not stop the writer
+    struct JobEvent* slots;
+    unsigned long head;  // count of events added (only the shell thread changes it)
+    unsigned long tail;  // count of events written (only the writer thread changes it)
+    unsigned long droppedCount;  // events lost because the ring was full
+    bool isRunning;
+    bool isWriterWaiting;  // true while the writer thread is (about to be) blocked on wakeFD
+    pthread_t writerThread;
+    char* batch;  // the writer thread's output buffer
+};
+
+
+static struct EventLog GLOBAL_eventLog = {.fd = -1, .wakeFD = -1};
+
+
+/*
+* Appends a string to a buffer as a JSON string, with quotes and escapes
+* return: the number of chars written
+*/
+static int writeJsonString(char* buffer, const char* text) {
+    int length = 0;
+
+    buffer[length++] = '"';
+    for (const unsigned char* character = (const unsigned char*) text; *character != '\0'; ++character) {
+        if (*character == '"' || *character == '\\') {
+            buffer[length++] = '\\';
+            buffer[length++] = *character;
+        } else if (*character < 0x20) {
+            length += sprintf(buffer + length, "\\u%04x", *character);
+        } else {
+            buffer[length++] = *character;
+        }
+    }
+    buffer[length++] = '"';
+
+    return length;
+}
+
+
+/*
+* Formats one job event as a line of JSON
+* buffer: where to write the line; must have room for EVENT_LOG_MAX_LINE_LENGTH chars
+* return: the length of the line
+*/
+static int formatJobEvent(char* buffer, struct JobEvent* event) {
+    const char* eventNames[] = {"spawn", "exit", "signal"};
+    int length = sprintf(buffer, "{\"event\":\"%s\",\"time\":%lld.%09ld,\"pid\":%d",
+            eventNames[event->type], (long long) event->time.tv_sec, event->time.tv_nsec, event->pid);
+
+    if (event->type == JOB_SPAWN) {
+        length += sprintf(buffer + length, ",\"background\":%s,\"command\":", event->isBackground ? "true" : "false");
+        length += writeJsonString(buffer + length, event->command);
+    } else {
+        length += sprintf(buffer + length, ",\"%s\":%d,\"background\":%s,\"duration\":%lld.%09lld",
+                event->type == JOB_EXIT ? "status" : "signal", event->status, event->isBackground ? "true" : "false",
+                event->durationNanoseconds / 1000000000LL, event->durationNanoseconds % 1000000000LL);
+    }
+
+    length += sprintf(buffer + length, "}\n");
+
+    return length;
+}
+
+
+/*
+* Writes every event waiting in the ring to the log file, in as few write()s as possible
+* Only the writer thread calls this
+*/
+static void flushEventLog() {
+    char* batch = GLOBAL_eventLog.batch;
+    int batchLength = 0;
+    unsigned long tail = __atomic_load_n(&GLOBAL_eventLog.tail, __ATOMIC_RELAXED);
+    unsigned long head = __atomic_load_n(&GLOBAL_eventLog.head, __ATOMIC_ACQUIRE);
+    unsigned long droppedCount = __atomic_exchange_n(&GLOBAL_eventLog.droppedCount, 0, __ATOMIC_RELAXED);
+
+    // note any events that were lost because the ring was full
+    if (droppedCount > 0) {
+        batchLength += sprintf(batch, "{\"event\":\"dropped\",\"count\":%lu}\n", droppedCount);
+    }
+
+    while (tail != head) {
+        // write out the batch when it can't fit another event
+        if (batchLength + EVENT_LOG_MAX_LINE_LENGTH > EVENT_LOG_BATCH_SIZE) {
+            write(GLOBAL_eventLog.fd, batch, batchLength);
+            batchLength = 0;
+        }
+
+        batchLength += formatJobEvent(batch + batchLength, &GLOBAL_eventLog.slots[tail & (EVENT_RING_CAPACITY - 1)]);
+        ++tail;
+
+        // the slot has been copied, so give it back to the shell
+        __atomic_store_n(&GLOBAL_eventLog.tail, tail, __ATOMIC_RELEASE);
+    }
+
+    if (batchLength > 0) {
+        write(GLOBAL_eventLog.fd, batch, batchLength);
+    }
+
+    return;
+}
+
+
+/*
+* Runs in a background thread, writing events to the log file as they arrive, so
+* logging never adds a write() to the log file to the shell's own work
+* Sleeps on the wake eventfd whenever the ring is empty
+*/
+static void* runEventLogWriter(void* unused) {
+    uint64_t wakeCount;
+
+    while (__atomic_load_n(&GLOBAL_eventLog.isRunning, __ATOMIC_ACQUIRE)) {
+        flushEventLog();
+
+        // say we're going to sleep, then check again, so an event added in between isn't missed
+        __atomic_store_n(&GLOBAL_eventLog.isWriterWaiting, true, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&GLOBAL_eventLog.head, __ATOMIC_SEQ_CST) == __atomic_load_n(&GLOBAL_eventLog.tail, __ATOMIC_RELAXED)
+                && __atomic_load_n(&GLOBAL_eventLog.isRunning, __ATOMIC_SEQ_CST)) {
+            while (read(GLOBAL_eventLog.wakeFD, &wakeCount, sizeof(wakeCount)) == -1 && errno == EINTR) {
+            }
+        }
+        __atomic_store_n(&GLOBAL_eventLog.isWriterWaiting, false, __ATOMIC_RELAXED);
+    }
+
+    // get anything logged while stopping
+    flushEventLog();
+
+    return NULL;
+}
+
+
+/*
+* Starts logging job events, if $SMALLSH_EVENTLOG names a log file
+* Events are appended to the file as JSON lines. The log is stopped (and flushed)
+* when smallsh exits, however it exits
+*/
+void startEventLog() {
+    char* logPath = getenv(EVENT_LOG_ENV_VAR);
+    sigset_t allSignals;
+    sigset_t originalMask;
+
+    if (!logPath || *logPath == '\0') {
+        return;
+    }
+
+    GLOBAL_eventLog.fd = open(logPath, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (GLOBAL_eventLog.fd == -1) {
+        fprintf(stderr, "cannot open %s for the event log\n", logPath);
+        fflush(NULL);
+        return;
+    }
+
+    GLOBAL_eventLog.wakeFD = eventfd(0, EFD_CLOEXEC);
+    if (GLOBAL_eventLog.wakeFD == -1) {
+        fprintf(stderr, "cannot start the event log: %s\n", strerror(errno));
+        fflush(NULL);
+        close(GLOBAL_eventLog.fd);
+        GLOBAL_eventLog.fd = -1;
+        return;
+    }
+
+    GLOBAL_eventLog.ownerPid = getpid();
+    GLOBAL_eventLog.slots = calloc(EVENT_RING_CAPACITY, sizeof(struct JobEvent));
+    GLOBAL_eventLog.batch = calloc(EVENT_LOG_BATCH_SIZE, sizeof(char));
+    GLOBAL_eventLog.isRunning = true;
+
+    // the writer thread blocks all signals, so SIGINT and SIGTSTP are always handled by the shell thread
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &originalMask);
+
+    if (pthread_create(&GLOBAL_eventLog.writerThread, NULL, runEventLogWriter, NULL) != 0) {
+        close(GLOBAL_eventLog.fd);
+        close(GLOBAL_eventLog.wakeFD);
+        GLOBAL_eventLog.fd = -1;
+        GLOBAL_eventLog.wakeFD = -1;
+    } else {
+        atexit(stopEventLog);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &originalMask, NULL);
+
+    return;
+}
+
+
+/*
+* Stops the event log writer thread after it writes any remaining events
+* Does nothing if the log isn't running, or in a child that was forked from smallsh
+*/
+void stopEventLog() {
+    uint64_t wakeCount = 1;
+
+    if (GLOBAL_eventLog.fd == -1 || getpid() != GLOBAL_eventLog.ownerPid) {
+        return;
+    }
+
+    __atomic_store_n(&GLOBAL_eventLog.isRunning, false, __ATOMIC_SEQ_CST);
+    write(GLOBAL_eventLog.wakeFD, &wakeCount, sizeof(wakeCount));
+    pthread_join(GLOBAL_eventLog.writerThread, NULL);
+
+    close(GLOBAL_eventLog.fd);
+    close(GLOBAL_eventLog.wakeFD);
+    GLOBAL_eventLog.fd = -1;
+    GLOBAL_eventLog.wakeFD = -1;
+
+    return;
+}
+
+
+/*
+* Records a job event in the event ring, if the event log is on
+* Never blocks, and only makes a system call to wake the writer thread when it's
+* asleep on an empty ring; if the ring is full, the event is dropped and counted instead
+* type: which kind of event
+* pid: the job's pid
+* status: exit value for JOB_EXIT, signal number for JOB_SIGNAL (ignored for JOB_SPAWN)
+* isBackground: whether the job runs in the background
+* durationNanoseconds: how long the job ran (ignored for JOB_SPAWN)
+* commandLine: the job's command line for JOB_SPAWN (NULL otherwise)
+*/
+void logJobEvent(enum JobEventType type, pid_t pid, int status, bool isBackground,
+                 long long durationNanoseconds, struct CommandLine* commandLine) {
+    if (GLOBAL_eventLog.fd == -1) {
+        return;
+    }
+
+    // only this thread changes head
+    unsigned long head = __atomic_load_n(&GLOBAL_eventLog.head, __ATOMIC_RELAXED);
+    unsigned long tail = __atomic_load_n(&GLOBAL_eventLog.tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail == EVENT_RING_CAPACITY) {
+        // the ring is full
+        __atomic_add_fetch(&GLOBAL_eventLog.droppedCount, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    struct JobEvent* event = &GLOBAL_eventLog.slots[head & (EVENT_RING_CAPACITY - 1)];
+    event->type = type;
+    event->pid = pid;
+    event->status = status;
+    event->isBackground = isBackground;
+    event->durationNanoseconds = durationNanoseconds;
+    clock_gettime(CLOCK_REALTIME, &event->time);  // served by the vDSO, not a system call
+
+    // copy the command line, truncating it if it doesn't fit
+    event->command[0] = '\0';
+    if (commandLine) {
+        int length = 0;
+
+        for (int argIndex = -1; argIndex < commandLine->argCount; ++argIndex) {
+            char* word = argIndex == -1 ? commandLine->command : commandLine->args[argIndex];
+            int wordLength = strlen(word);
+
+            if (length + wordLength + 1 >= EVENT_COMMAND_LENGTH) {
+                break;
+            }
+
+            if (length > 0) {
+                event->command[length++] = ' ';
+            }
+            memcpy(&event->command[length], word, wordLength);
+            length += wordLength;
+            event->command[length] = '\0';
+        }
+    }
+
+    // publish the event to the writer thread, and wake it if it's waiting for one
+    __atomic_store_n(&GLOBAL_eventLog.head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&GLOBAL_eventLog.isWriterWaiting, __ATOMIC_SEQ_CST)) {
+        uint64_t wakeCount = 1;
+        write(GLOBAL_eventLog.wakeFD, &wakeCount, sizeof(wakeCount));
+    }
+
+    return;
+}
@@ -0,0 +1,320 @@
+// Running builtin and third-party commands
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+int GLOBAL_lastForegroundChildStatus = 0;  // default to 0 per specs
+bool GLOBAL_fgOnlyMode = false;
+
+// commands handled by smallsh itself, offered by tab completion
+const char* GLOBAL_builtinCommands[] = {"cd", "exit", "status", "history", "wait", "batch", "tee", "every", "at", "timers", "cancel", "prefetch", "repeat", "for", NULL};
+
+
+/*
+* Checks whether a command is handled by smallsh itself
+* command: the first word of a command line
+* return: true if command is a builtin; false if it's a third-party command
+*/
+static bool isBuiltinCommand(char* command) {
+    for (int index = 0; GLOBAL_builtinCommands[index]; ++index) {
+        if (isEqualString(command, (char*) GLOBAL_builtinCommands[index])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*
+* Changes the current directory, supporting relative and absolute paths
+* If no argument is given, changes to the user's home directory
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+static void handleCdCommand(struct CommandLine* commandLine) {
+    // handle the command with no argument
+    if (!commandLine->args[0]) {
+        // change the current directory to the HOME directory
+        chdir(getenv("HOME"));
+    } else {
+        // change the current directory to the specified path
+        chdir(commandLine->args[0]);
+    }
+
+    return;
+}
+
+
+/*
+* kills processes or jobs started by smallsh and terminates smallsh
+*/
+void handleExitCommand() {
+    // kill processes or jobs started by smallsh
+
+    // write out the rest of the event log
+    stopEventLog();
+
+    // terminate smallsh
+    exit(EXIT_SUCCESS);
+}
+
+
+/*
+* Prints the exit status of the last foreground process run by smallsh
+* If no foreground command has been run yet, prints 0
+*/
+static void handleStatusCommand() {
+    // print notice of exit status for last foreground child
+    printf("exit value %d\n", GLOBAL_lastForegroundChildStatus);
+    fflush(NULL);
+
+    return;
+}
+
+
+/*
+* executes a command not directly supported by smallsh
+* (source: adapted from lecture material)
+* commandLine: pointer to a CommandLine struct which has the command line's details
+* isBackground: if true, the command runs in the background
+*/
+static void handleThirdPartyCommand(struct CommandLine* commandLine, bool isBackground) {
+    pid_t spawnPid = -5;
+    int childStatus = 0;
+    struct timespec startTime;
+    char* childArgv[MAX_ARG_COUNT];  // must use char*[] for execvp() to work with args
+    int copyIndex = 0;  // used by the loop that copies args into childArgv
+    char* backgroundNoticePrefix = "background pid is ";
+    char* childPidString = calloc(10, sizeof(char));  // room for 9 digits
+    char* backgroundNotice = calloc(strlen(backgroundNoticePrefix) + 10, sizeof(char));  // room for 9 digits
+
+    // a background child that couldn't be tracked would never be reaped, so don't start it
+    if (isBackground && !hasRoomForBgChild()) {
+        fprintf(stderr, "cannot run %s in the background: %d background processes are already running\n",
+                commandLine->command, MAX_BG_CHILDREN);
+        fflush(NULL);
+        free(childPidString);
+        free(backgroundNotice);
+        return;
+    }
+
+    // fork off a child process
+    spawnPid = fork();
+
+    switch (spawnPid) {
+        case -1:
+            // fork() failed to create a child process
+			printToTerminal("fork() failed to create a child process\n", true);
+            exit(EXIT_FAILURE);
+            break;
+        
+        case 0:
+            // Only the child process will execute this, because its spawnPid is 0
+
+            // ignore SIGTSTP
+            setSIGTSTPhandler(true);
+
+            // check if this should be run in the background
+            if (isBackground) {
+                handleNewBgChild();
+            } else {
+                // this is a foreground child, so SIGINT shouldn't be blocked (per specs)
+                resetSIGINThandler();
+            }
+
+            // Redirect streams if the user asked to
+            // Else, if it's background, suppress input and output (per specs)
+            // (the child leaves with _exit(), since exit() would flush smallsh's copy of
+            // the stdin stream, which seeks a script smallsh is reading back to where
+            // the child's copy had read up to)
+            if (applyRedirections(commandLine, isBackground) == -1) {
+                _exit(1);
+            }
+
+            // copy output to the >+ files (this process stays behind to do it, and a new one runs the command)
+            if (commandLine->teeFileCount > 0 && startTeeWorker(commandLine) == -1) {
+                _exit(1);
+            }
+
+            /* 
+            Prepare a vector of args for execvp 
+            */
+
+            // execvp needs the first arg to be the command filename
+            childArgv[0] = commandLine->command;
+
+            // copy the args provided by user
+            while (copyIndex < commandLine->argCount) {
+                childArgv[copyIndex + 1] = commandLine->args[copyIndex];
+                ++copyIndex;
+            }
+
+            // execvp needs these args to be terminated by a NULL pointer
+            childArgv[copyIndex + 1] = NULL;
+           
+            /* 
+            Execute the third-party command here in this child process 
+            */
+
+            // (use the PATH variable to look for non-built in commands, 
+            // and allow shell scripts to be executed)
+            // In case of success, the new program will terminate the process
+            execvp(childArgv[0], childArgv);
+
+            // This code will only be executed if exec returns to 
+            // the original child process because of an error
+            printToTerminal("", true);
+            _exit(EXIT_FAILURE + 1);  // the child process must exit on failure as well
+            break;
+        
+        default:
+            // Only the parent process (smallsh) will execute this. Its spawnPid is the child's process ID
+            logJobEvent(JOB_SPAWN, spawnPid, 0, isBackground, 0, commandLine);
+
+            if (!isBackground) {
+                // Wait for child to finish
+                clock_gettime(CLOCK_MONOTONIC, &startTime);
+                spawnPid = waitForForegroundChild(spawnPid, &childStatus);
+
+                // update status
+                if (WIFEXITED(childStatus)) {
+                    // child terminated normally 
+                    GLOBAL_lastForegroundChildStatus = WEXITSTATUS(childStatus);
+                    logJobEvent(JOB_EXIT, spawnPid, WEXITSTATUS(childStatus), false, getElapsedNanoseconds(&startTime), NULL);
+                } else {
+                    // child terminated abnormally
+                    GLOBAL_lastForegroundChildStatus = WTERMSIG(childStatus);
+                    logJobEvent(JOB_SIGNAL, spawnPid, WTERMSIG(childStatus), false, getElapsedNanoseconds(&startTime), NULL);
+                }
+            } else {
+                // skip the wait and let the child become a zombie process (reaped in outer loop)
+
+                // track background children
+                registerNewBgChildPid(spawnPid);
+                
+                // convert number to string
+                sprintf(childPidString, "%d", spawnPid);
+
+                // compose and print notice of background process
+                strcat(backgroundNotice, backgroundNoticePrefix);
+                strcat(backgroundNotice, childPidString);
+                strcat(backgroundNotice, "\n");
+                printToTerminal(backgroundNotice, false);
+            }
+
+            break;
+    }
+
+    free(childPidString);
+    free(backgroundNotice);
+
+    return;
+}
+
+
+/*
+* executes a command given to smallsh
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void executeCommand(struct CommandLine* commandLine) {
+    const char commentChar = '#';
+    int savedStreams[3] = {-1, -1, -1};
+    bool isRedirectedBuiltin = false;
+
+    // every and at keep their redirections for the command they schedule
+    bool isInProcessBuiltin = commandLine->command[0] != commentChar && isBuiltinCommand(commandLine->command)
+            && !isEqualString(commandLine->command, "every") && !isEqualString(commandLine->command, "at");
+
+    // >+ needs a process of its own to copy the output, which builtins don't get
+    if (isInProcessBuiltin && commandLine->teeFileCount > 0) {
+        fprintf(stderr, "%s: >+ only works with external commands\n", commandLine->command);
+        fflush(NULL);
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    // Builtins run in smallsh itself, so their redirections are applied here and undone
+    // afterward. If one fails, the builtin doesn't run (and smallsh keeps running).
+    if (isInProcessBuiltin && (commandLine->inFile || commandLine->hereDocument || commandLine->outFile
+                || commandLine->errFile || commandLine->isErrToOut)) {
+        isRedirectedBuiltin = true;
+
+        if (redirectStandardStreams(commandLine, savedStreams) == -1) {
+            restoreStandardStreams(savedStreams);
+            return;
+        }
+    }
+
+    // ignore comment lines
+    if (commandLine->command[0] == commentChar) {
+        // ignore this whole line; it's a comment
+    } else if (isEqualString(commandLine->command, "cd")) {
+        // execute the cd command
+        handleCdCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "exit")) {
+        // execute the exit command
+        handleExitCommand();
+    } else if (isEqualString(commandLine->command, "status")) {
+        // execute the status command
+        handleStatusCommand();
+    } else if (isEqualString(commandLine->command, "history")) {
+        // execute the history command
+        handleHistoryCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "wait")) {
+        // execute the wait command
+        handleWaitCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "batch")) {
+        // execute the batch command
+        handleBatchCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "tee")) {
+        // execute the tee command
+        handleTeeCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "every")) {
+        // execute the every command
+        handleEveryCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "at")) {
+        // execute the at command
+        handleAtCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "timers")) {
+        // execute the timers command
+        handleTimersCommand();
+    } else if (isEqualString(commandLine->command, "cancel")) {
+        // execute the cancel command
+        handleCancelCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "prefetch")) {
+        // execute the prefetch command
+        handlePrefetchCommand(commandLine);
+    } else if (isEqualString(commandLine->command, "repeat") || isEqualString(commandLine->command, "for")) {
+        // loops are run by runLoopCommand() from a whole line of input, so they can't
+        // be run from inside another loop or scheduled
+        fprintf(stderr, "%s: loops can only be run at the prompt\n", commandLine->command);
+        fflush(NULL);
+        GLOBAL_lastForegroundChildStatus = 1;
+    } else {
+        // execute a third-party command
+        handleThirdPartyCommand(commandLine, commandLine->isBackground && !GLOBAL_fgOnlyMode);
+    }
+
+    if (isRedirectedBuiltin) {
+        restoreStandardStreams(savedStreams);
+    }
+
+    return;
+}
+
+
+/*
+* executes a command in the background, even in foreground-only mode,
+* for commands smallsh starts on its own (like scheduled ones)
+* Builtins still run in smallsh itself
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void executeBackgroundCommand(struct CommandLine* commandLine) {
+    if (isBuiltinCommand(commandLine->command)) {
+        executeCommand(commandLine);
+    } else {
+        handleThirdPartyCommand(commandLine, true);
+    }
+
+    return;
+}
@@ -0,0 +1,119 @@
+// Expansion of the $$ variable
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* Returns the pid of smallsh as a string
+*/
+static char* getPidString() {
+    char* pidString = calloc(10 + 1, sizeof(char));  // allows 10 digits
+    pid_t pid = getpid();
+
+    // convert to string
+    sprintf(pidString, "%d", pid);
+
+    return pidString;
+}
+
+
+/*
+* Imitates strtok() but uses a string delimiter
+* (adapted from https://stackoverflow.com/a/29848367/14257952)
+* str: input string to tokenize
+* delim: delimiter
+* return: the next segment of str originally ending with delim (the final segment is returned regardless)
+*/
+static char* strtokm(char *str, const char *delim, bool *isFinalSegment)
+{
+    static char *tok;
+    static char *next;
+    char *temp;
+
+    // check for invalid delimiter param
+    if (delim == NULL) return NULL;
+
+    // extract the next token segment, starting at the beginning of str
+    // if str was provided
+    tok = (str) ? str : next;
+    if (tok == NULL) return NULL;
+
+    // check for occurrence of delimiter in this token segment
+    temp = strstr(tok, delim);
+
+    if (temp) {
+        // move next pointer past the delimiter and reset m
+        next = temp + strlen(delim);
+        *temp = '\0';
+    } else {
+        // this token segment doesn't have the delimiter, so it's the end
+        next = NULL;
+    }
+
+    if (next == NULL) {
+        *isFinalSegment = true;
+    }
+
+    return tok;
+}
+
+
+/*
+* Replaces all instances of the pid variable ($$) in stringIn with the smallsh pid
+* stringIn: string which may contain instances of "$$"
+* return: the input string with instances of "$$" replaced by the smallsh pid
+*/
+char* expandPidVariable(char* stringIn) {
+    char* pidVariable = "$$";
+    char* pidString = getPidString();
+    char* stringOut = calloc(strlen(stringIn) + 1, sizeof(char));
+    char* stringTemp = calloc(strlen(stringIn) + 1, sizeof(char));
+    int newLength = 0;
+    int originalLength = strlen(stringIn);
+    bool* isFinalSegment = malloc(sizeof(bool));
+    *isFinalSegment = false;
+    char* token = strtokm(stringIn, pidVariable, isFinalSegment);
+
+    if (strlen(token) == originalLength) {
+        // there are no occurrences of the pid variable
+        strcpy(stringOut, stringIn);
+    } else {
+        // There are some occurrences of the pid variable.
+        // Continue to copy segments of stringIn while substituting
+        // the smallsh pid for the variable
+        while (token) {
+            // copy the string up to this point
+            strcpy(stringTemp, stringOut);
+
+            // Resize stringOut to fit another pid
+            // Make space for stringTemp + this token + pid
+            free(stringOut);  // stringOut was copied to stringTemp
+            newLength = strlen(stringTemp) + strlen(token) + strlen(pidString) + 1;
+            stringOut = calloc(newLength, sizeof(char));
+
+            // restore stringOut from before this iteration
+            strcpy(stringOut, stringTemp);
+            strcat(stringOut, token);
+
+            // Check for the special case of the final segment, because strtokm() will need to 
+            // return a token for the final segment even if there isn't a delimiter in it
+            if (!*isFinalSegment) {
+                // append the pid, because the delimiter was found in this token
+                strcat(stringOut, pidString);
+            }
+
+            // for next iteration
+            free(stringTemp);
+            stringTemp = calloc(newLength, sizeof(char));
+
+            // try to extract another token
+            token = strtokm(NULL, pidVariable, isFinalSegment);
+        }
+    }
+
+    free(pidString);
+    free(stringTemp);
+    free(isFinalSegment);
+
+    return stringOut;
+}
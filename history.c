@@ -0,0 +1,732 @@
+// Persistent command history with a hash index and a prefix index
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+struct History GLOBAL_history = {.fd = -1};
+
+
+/*
+* Hashes a string with FNV-1a
+* (source: http://www.isthe.com/chongo/tech/comp/fnv/)
+* text: any string, not necessarily null-terminated
+* length: number of chars in text
+* return: the 64-bit hash of text
+*/
+static uint64_t hashText(const char* text, int length) {
+    uint64_t hash = 14695981039346656037ULL;  // FNV offset basis
+
+    for (int index = 0; index < length; ++index) {
+        hash ^= (unsigned char) text[index];
+        hash *= 1099511628211ULL;  // FNV prime
+    }
+
+    return hash;
+}
+
+
+/*
+* Compares two strings which aren't necessarily null-terminated, like strcmp()
+* return: negative if text1 sorts first, positive if text2 sorts first, 0 if equal
+*/
+static int compareText(const char* text1, int length1, const char* text2, int length2) {
+    int result = memcmp(text1, text2, length1 < length2 ? length1 : length2);
+
+    // if one is a prefix of the other, the shorter one sorts first
+    if (result == 0) {
+        result = length1 - length2;
+    }
+
+    return result;
+}
+
+
+/*
+* Opens and memory-maps the history file, without reading its entries
+* The file is $SMALLSH_HISTFILE if that's set, or ~/.smallsh_history if not.
+* If the file can't be opened, history is kept for this session only.
+* Only the file as it is now is read: commands another smallsh appends to it later
+* show up in sessions started after that, not in this one (like bash's default)
+*/
+void loadHistory() {
+    struct stat fileInfo;
+    char* historyPath = getenv(HISTORY_FILE_ENV_VAR);
+    char* homePath = getenv("HOME");
+    char* defaultPath = NULL;
+
+    // use the default file in the home directory, if no file was specified
+    if (!historyPath && homePath) {
+        defaultPath = calloc(strlen(homePath) + strlen(HISTORY_FILE_NAME) + 2, sizeof(char));
+        sprintf(defaultPath, "%s/%s", homePath, HISTORY_FILE_NAME);
+        historyPath = defaultPath;
+    }
+
+    if (!historyPath) {
+        return;
+    }
+
+    // O_APPEND keeps each new entry intact when other sessions share the file
+    GLOBAL_history.fd = open(historyPath, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    free(defaultPath);
+
+    if (GLOBAL_history.fd == -1 || fstat(GLOBAL_history.fd, &fileInfo) == -1) {
+        return;
+    }
+
+    // map the existing history (a private mapping doesn't see entries appended later,
+    // which is fine because they're also added to memory)
+    if (fileInfo.st_size > 0) {
+        GLOBAL_history.mappedFile = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, GLOBAL_history.fd, 0);
+
+        if (GLOBAL_history.mappedFile == MAP_FAILED) {
+            GLOBAL_history.mappedFile = NULL;
+        } else {
+            GLOBAL_history.mappedLength = fileInfo.st_size;
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Finds the hash slot for a history entry's text
+* return: the index of the slot holding the entry with this text, or of the
+*         empty slot where it belongs if there is no such entry
+*/
+static int findHistoryHashSlot(const char* text, int length, uint64_t hash) {
+    int mask = GLOBAL_history.hashCapacity - 1;  // capacity is a power of 2
+    int slot = hash & mask;
+
+    // linear probing
+    while (GLOBAL_history.hashSlots[slot] != -1) {
+        struct HistoryEntry* entry = &GLOBAL_history.entries[GLOBAL_history.hashSlots[slot]];
+
+        // only compare the text if the hash matches
+        if (entry->hash == hash && compareText(entry->text, entry->length, text, length) == 0) {
+            break;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+
+/*
+* Doubles the capacity of the history hash table and re-inserts every unique entry
+*/
+static void growHistoryHashTable() {
+    int* oldSlots = GLOBAL_history.hashSlots;
+    int oldCapacity = GLOBAL_history.hashCapacity;
+
+    GLOBAL_history.hashCapacity = oldCapacity ? oldCapacity * 2 : 1024;
+    GLOBAL_history.hashSlots = malloc(GLOBAL_history.hashCapacity * sizeof(int));
+    memset(GLOBAL_history.hashSlots, -1, GLOBAL_history.hashCapacity * sizeof(int));  // all slots empty
+
+    for (int index = 0; index < oldCapacity; ++index) {
+        if (oldSlots[index] != -1) {
+            struct HistoryEntry* entry = &GLOBAL_history.entries[oldSlots[index]];
+            GLOBAL_history.hashSlots[findHistoryHashSlot(entry->text, entry->length, entry->hash)] = oldSlots[index];
+        }
+    }
+
+    free(oldSlots);
+
+    return;
+}
+
+
+/*
+* Finds where a text belongs in the prefix index, using binary search
+* return: the index of the first sorted entry whose text is not less than the given text
+*/
+static int findSortedHistoryPosition(const char* text, int length) {
+    int low = 0;
+    int high = GLOBAL_history.sortedCount;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        struct HistoryEntry* entry = &GLOBAL_history.entries[GLOBAL_history.sortedEntries[middle]];
+
+        if (compareText(entry->text, entry->length, text, length) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+/*
+* Finds the end of the range of prefix index entries that start with a prefix, using
+* binary search
+* return: the position just past the last sorted entry starting with prefix
+*/
+static int findSortedPrefixEnd(const char* prefix, int prefixLength) {
+    int low = 0;
+    int high = GLOBAL_history.sortedCount;
+
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        struct HistoryEntry* entry = &GLOBAL_history.entries[GLOBAL_history.sortedEntries[middle]];
+        int comparedLength = entry->length < prefixLength ? entry->length : prefixLength;
+
+        // compared only up to the prefix's length, entries with the prefix are equal to it
+        if (compareText(entry->text, comparedLength, prefix, prefixLength) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+
+/*
+* Recomputes the newest-entry tree for a range of prefix index positions
+* firstPosition: the first position whose entry changed
+* lastPosition: the last position whose entry changed
+*/
+static void updateNewestTree(int firstPosition, int lastPosition) {
+    int* tree = GLOBAL_history.newestTree;
+    int leaves = GLOBAL_history.newestTreeLeaves;
+
+    // the leaves are the prefix index itself
+    for (int position = firstPosition; position <= lastPosition; ++position) {
+        tree[leaves + position] = position < GLOBAL_history.sortedCount ? GLOBAL_history.sortedEntries[position] : -1;
+    }
+
+    // each node above them holds the newer of its two children's entries
+    for (int first = (leaves + firstPosition) / 2, last = (leaves + lastPosition) / 2; first >= 1; first /= 2, last /= 2) {
+        for (int node = first; node <= last; ++node) {
+            tree[node] = tree[2 * node] > tree[2 * node + 1] ? tree[2 * node] : tree[2 * node + 1];
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Builds the newest-entry tree over the whole prefix index, with room for it to
+* grow to twice its size before the tree has to be rebuilt
+*/
+static void buildNewestTree() {
+    int leaves = 1;
+
+    while (leaves <= GLOBAL_history.sortedCount * 2) {
+        leaves *= 2;
+    }
+
+    free(GLOBAL_history.newestTree);
+    GLOBAL_history.newestTree = malloc(2 * leaves * sizeof(int));
+    GLOBAL_history.newestTree[0] = -1;  // unused
+    GLOBAL_history.newestTreeLeaves = leaves;
+    updateNewestTree(0, leaves - 1);
+
+    return;
+}
+
+
+/*
+* Finds the newest entry older than beforeIndex in a range of prefix index positions,
+* under one node of the newest-entry tree
+* Subtrees with nothing newer than the best match so far are skipped, so this only
+* looks beyond one path down the tree for entries at or after beforeIndex
+* node: the node, which covers positions nodeFirst to nodeLast
+* firstPosition: the first position in the range
+* lastPosition: the last position in the range
+* beforeIndex: only entries older than this entry index are considered
+* newestIndex: the best match so far, or -1
+* return: the index of the newest match, or newestIndex if there's no newer one
+*/
+static int findNewestInTree(int node, int nodeFirst, int nodeLast, int firstPosition, int lastPosition,
+                            int beforeIndex, int newestIndex) {
+    int newestUnderNode = GLOBAL_history.newestTree[node];
+
+    if (nodeLast < firstPosition || nodeFirst > lastPosition || newestUnderNode <= newestIndex) {
+        return newestIndex;
+    }
+
+    // the whole subtree is in range, and even its newest entry is old enough
+    if (firstPosition <= nodeFirst && nodeLast <= lastPosition && newestUnderNode < beforeIndex) {
+        return newestUnderNode;
+    }
+
+    // a single entry that's too new
+    if (nodeFirst == nodeLast) {
+        return newestIndex;
+    }
+
+    int middle = nodeFirst + (nodeLast - nodeFirst) / 2;
+    newestIndex = findNewestInTree(2 * node, nodeFirst, middle, firstPosition, lastPosition, beforeIndex, newestIndex);
+
+    return findNewestInTree(2 * node + 1, middle + 1, nodeLast, firstPosition, lastPosition, beforeIndex, newestIndex);
+}
+
+
+/*
+* Compares two history entries by their text, for qsort() of entry indexes
+*/
+static int compareHistoryEntryTexts(const void* entryIndex1, const void* entryIndex2) {
+    struct HistoryEntry* entry1 = &GLOBAL_history.entries[*(const int*) entryIndex1];
+    struct HistoryEntry* entry2 = &GLOBAL_history.entries[*(const int*) entryIndex2];
+
+    return compareText(entry1->text, entry1->length, entry2->text, entry2->length);
+}
+
+
+/*
+* Merges the entries waiting in unsortedEntries into the prefix index
+* They're sorted, then merged in from the back, so the index is written once per batch
+* instead of shifted once per entry
+*/
+static void mergeUnsortedHistory() {
+    int* sortedEntries = GLOBAL_history.sortedEntries;
+    int* newEntries = GLOBAL_history.unsortedEntries;
+
+    if (GLOBAL_history.unsortedCount == 0) {
+        return;
+    }
+
+    qsort(newEntries, GLOBAL_history.unsortedCount, sizeof(int), compareHistoryEntryTexts);
+
+    // fill the index from its new end, taking the later of the two next entries each time
+    // (the prefix index has room for every entry)
+    int oldPosition = GLOBAL_history.sortedCount - 1;
+    int newPosition = GLOBAL_history.unsortedCount - 1;
+    int position = GLOBAL_history.sortedCount + GLOBAL_history.unsortedCount - 1;
+
+    while (newPosition >= 0) {
+        if (oldPosition >= 0 && compareHistoryEntryTexts(&sortedEntries[oldPosition], &newEntries[newPosition]) > 0) {
+            sortedEntries[position] = sortedEntries[oldPosition];
+            --oldPosition;
+        } else {
+            sortedEntries[position] = newEntries[newPosition];
+            --newPosition;
+        }
+
+        --position;
+    }
+
+    GLOBAL_history.sortedCount += GLOBAL_history.unsortedCount;
+    GLOBAL_history.unsortedCount = 0;
+
+    // the entries before the first new one didn't move
+    if (GLOBAL_history.sortedCount > GLOBAL_history.newestTreeLeaves) {
+        buildNewestTree();
+    } else {
+        updateNewestTree(oldPosition + 1, GLOBAL_history.sortedCount - 1);
+    }
+
+    return;
+}
+
+
+/*
+* Adds one line to the in-memory history, deduplicating it against earlier entries
+* text: the entry's text, which must stay valid for the rest of the session
+* length: number of chars in text
+*/
+static void indexHistoryEntry(const char* text, int length) {
+    // make room for another entry
+    if (GLOBAL_history.entryCount == GLOBAL_history.entryCapacity) {
+        GLOBAL_history.entryCapacity = GLOBAL_history.entryCapacity ? GLOBAL_history.entryCapacity * 2 : 1024;
+        GLOBAL_history.entries = realloc(GLOBAL_history.entries, GLOBAL_history.entryCapacity * sizeof(struct HistoryEntry));
+    }
+
+    // keep the hash table at most half full so probing stays short
+    if ((GLOBAL_history.uniqueCount + 1) * 2 > GLOBAL_history.hashCapacity) {
+        growHistoryHashTable();
+    }
+
+    int newIndex = GLOBAL_history.entryCount;
+    uint64_t hash = hashText(text, length);
+    GLOBAL_history.entries[newIndex].text = text;
+    GLOBAL_history.entries[newIndex].length = length;
+    GLOBAL_history.entries[newIndex].hash = hash;
+    GLOBAL_history.entries[newIndex].isSuperseded = false;
+    ++GLOBAL_history.entryCount;
+
+    int slot = findHistoryHashSlot(text, length, hash);
+
+    if (GLOBAL_history.hashSlots[slot] != -1) {
+        // this is a duplicate. The new entry replaces the old one,
+        // including at the same spot in the prefix index, since the text is the same
+        int oldIndex = GLOBAL_history.hashSlots[slot];
+        GLOBAL_history.entries[oldIndex].isSuperseded = true;
+        GLOBAL_history.hashSlots[slot] = newIndex;
+
+        if (GLOBAL_history.isSorted) {
+            int position = findSortedHistoryPosition(text, length);
+
+            if (position < GLOBAL_history.sortedCount && GLOBAL_history.sortedEntries[position] == oldIndex) {
+                GLOBAL_history.sortedEntries[position] = newIndex;
+                updateNewestTree(position, position);
+            } else {
+                // the old entry is still waiting to be merged into the prefix index
+                for (int index = 0; index < GLOBAL_history.unsortedCount; ++index) {
+                    if (GLOBAL_history.unsortedEntries[index] == oldIndex) {
+                        GLOBAL_history.unsortedEntries[index] = newIndex;
+                        break;
+                    }
+                }
+            }
+        }
+    } else {
+        // this is a new unique entry
+        GLOBAL_history.hashSlots[slot] = newIndex;
+        ++GLOBAL_history.uniqueCount;
+
+        if (GLOBAL_history.isSorted) {
+            // it waits to be merged into the prefix index with others
+            GLOBAL_history.unsortedEntries = realloc(GLOBAL_history.unsortedEntries, (GLOBAL_history.unsortedCount + 1) * sizeof(int));
+            GLOBAL_history.unsortedEntries[GLOBAL_history.unsortedCount] = newIndex;
+            ++GLOBAL_history.unsortedCount;
+
+            if (GLOBAL_history.unsortedCount * GLOBAL_history.unsortedCount > GLOBAL_history.sortedCount) {
+                mergeUnsortedHistory();
+            }
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Reads the entries out of the memory-mapped history file, if that hasn't been done yet
+* Entries added earlier in this session are indexed after the ones from the file
+*/
+void indexHistory() {
+    if (GLOBAL_history.isIndexed) {
+        return;
+    }
+
+    GLOBAL_history.isIndexed = true;
+
+    // index each line in the mapped file
+    char* lineStart = GLOBAL_history.mappedFile;
+    char* fileEnd = GLOBAL_history.mappedFile + GLOBAL_history.mappedLength;
+
+    while (lineStart && lineStart < fileEnd) {
+        char* lineEnd = memchr(lineStart, '\n', fileEnd - lineStart);
+
+        // the last line might not have a newline
+        if (!lineEnd) {
+            lineEnd = fileEnd;
+        }
+
+        if (lineEnd > lineStart) {
+            indexHistoryEntry(lineStart, lineEnd - lineStart);
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    // index the entries from this session
+    for (int index = 0; index < GLOBAL_history.pendingCount; ++index) {
+        indexHistoryEntry(GLOBAL_history.pendingEntries[index], strlen(GLOBAL_history.pendingEntries[index]));
+    }
+
+    free(GLOBAL_history.pendingEntries);
+    GLOBAL_history.pendingEntries = NULL;
+    GLOBAL_history.pendingCount = 0;
+
+    return;
+}
+
+
+/*
+* An entry to be sorted into the prefix index, with its first 8 chars packed into an
+* integer so most comparisons don't have to look at the text itself
+*/
+struct HistorySortKey {
+    uint64_t leadingChars;
+    int entryIndex;
+};
+
+
+/*
+* Compares two history sort keys by the text of their entries, for qsort()
+*/
+static int compareHistorySortKeys(const void* key1, const void* key2) {
+    const struct HistorySortKey* sortKey1 = key1;
+    const struct HistorySortKey* sortKey2 = key2;
+
+    if (sortKey1->leadingChars != sortKey2->leadingChars) {
+        return sortKey1->leadingChars < sortKey2->leadingChars ? -1 : 1;
+    }
+
+    // the first 8 chars match, so compare the whole text
+    struct HistoryEntry* entry1 = &GLOBAL_history.entries[sortKey1->entryIndex];
+    struct HistoryEntry* entry2 = &GLOBAL_history.entries[sortKey2->entryIndex];
+
+    return compareText(entry1->text, entry1->length, entry2->text, entry2->length);
+}
+
+
+/*
+* Builds the prefix index, if that hasn't been done yet
+* It is kept sorted as new entries are added after this
+*/
+static void sortHistory() {
+    indexHistory();
+
+    if (GLOBAL_history.isSorted) {
+        return;
+    }
+
+    struct HistorySortKey* sortKeys = malloc((GLOBAL_history.uniqueCount + 1) * sizeof(struct HistorySortKey));
+    int sortedCount = 0;
+
+    // the hash table holds exactly the newest entry for each unique text
+    for (int index = 0; index < GLOBAL_history.hashCapacity; ++index) {
+        int entryIndex = GLOBAL_history.hashSlots[index];
+
+        if (entryIndex != -1) {
+            struct HistoryEntry* entry = &GLOBAL_history.entries[entryIndex];
+
+            // pack the leading chars most significant first, so integer order matches text order
+            uint64_t leadingChars = 0;
+            for (int charIndex = 0; charIndex < 8; ++charIndex) {
+                leadingChars <<= 8;
+
+                if (charIndex < entry->length) {
+                    leadingChars |= (unsigned char) entry->text[charIndex];
+                }
+            }
+
+            sortKeys[sortedCount].leadingChars = leadingChars;
+            sortKeys[sortedCount].entryIndex = entryIndex;
+            ++sortedCount;
+        }
+    }
+
+    qsort(sortKeys, sortedCount, sizeof(struct HistorySortKey), compareHistorySortKeys);
+
+    // it needs room for every unique entry this session could add, and each new entry
+    // also grows entryCapacity, so size it the same way
+    GLOBAL_history.sortedEntries = malloc((GLOBAL_history.entryCapacity + 1) * sizeof(int));
+    for (int index = 0; index < sortedCount; ++index) {
+        GLOBAL_history.sortedEntries[index] = sortKeys[index].entryIndex;
+    }
+
+    free(sortKeys);
+    GLOBAL_history.sortedCount = sortedCount;
+    GLOBAL_history.isSorted = true;
+    buildNewestTree();
+
+    return;
+}
+
+
+/*
+* Appends a command to the history file and the in-memory history
+* Empty commands and repeats of the previous command aren't added
+* command: a line of user input, before $$ expansion
+*/
+void addHistoryEntry(char* command) {
+    static char* previousCommand = NULL;
+    int length = strlen(command);
+
+    if (length == 0 || (previousCommand && isEqualString(command, previousCommand))) {
+        return;
+    }
+
+    // keep a copy, since the history refers to it for the rest of the session
+    char* entryText = calloc(length + 2, sizeof(char));
+    strcpy(entryText, command);
+    previousCommand = entryText;
+
+    // write the entry and its newline together, so concurrent sessions can't interleave them
+    if (GLOBAL_history.fd != -1) {
+        entryText[length] = '\n';
+        write(GLOBAL_history.fd, entryText, length + 1);
+        entryText[length] = '\0';
+    }
+
+    if (GLOBAL_history.isIndexed) {
+        // the prefix index's capacity tracks entryCapacity, so grow it first if needed
+        if (GLOBAL_history.isSorted && GLOBAL_history.entryCount == GLOBAL_history.entryCapacity) {
+            GLOBAL_history.sortedEntries = realloc(GLOBAL_history.sortedEntries, (GLOBAL_history.entryCapacity * 2 + 1) * sizeof(int));
+        }
+
+        indexHistoryEntry(entryText, length);
+    } else {
+        // wait to index it until the file's entries are indexed
+        GLOBAL_history.pendingEntries = realloc(GLOBAL_history.pendingEntries, (GLOBAL_history.pendingCount + 1) * sizeof(char*));
+        GLOBAL_history.pendingEntries[GLOBAL_history.pendingCount] = entryText;
+        ++GLOBAL_history.pendingCount;
+    }
+
+    return;
+}
+
+
+/*
+* Finds the newest history entry that starts with the given prefix, using the prefix index
+* and the newest-entry tree over it, then checking the entries not yet merged into it
+* prefix: any string
+* beforeIndex: only entries older than this entry index are considered
+* return: the index of the matching entry, or -1 if there isn't one
+*/
+int findHistoryByPrefix(const char* prefix, int beforeIndex) {
+    int prefixLength = strlen(prefix);
+
+    sortHistory();
+
+    // entries with this prefix are all together in the prefix index
+    int firstPosition = findSortedHistoryPosition(prefix, prefixLength);
+    int lastPosition = findSortedPrefixEnd(prefix, prefixLength) - 1;
+    int newestIndex = findNewestInTree(1, 0, GLOBAL_history.newestTreeLeaves - 1, firstPosition, lastPosition, beforeIndex, -1);
+
+    for (int index = 0; index < GLOBAL_history.unsortedCount; ++index) {
+        int entryIndex = GLOBAL_history.unsortedEntries[index];
+        struct HistoryEntry* entry = &GLOBAL_history.entries[entryIndex];
+
+        if (entryIndex > newestIndex && entryIndex < beforeIndex
+                && entry->length >= prefixLength && memcmp(entry->text, prefix, prefixLength) == 0) {
+            newestIndex = entryIndex;
+        }
+    }
+
+    return newestIndex;
+}
+
+
+/*
+* Copies a history entry's text into a new null-terminated string
+* entryIndex: index of an entry in the history
+* return: a copy of the entry's text
+*/
+static char* copyHistoryEntry(int entryIndex) {
+    struct HistoryEntry* entry = &GLOBAL_history.entries[entryIndex];
+    char* text = calloc(entry->length + 1, sizeof(char));
+    memcpy(text, entry->text, entry->length);
+
+    return text;
+}
+
+
+/*
+* Replaces a history reference with the command it refers to
+* Supported references are
+*       !!          the previous command
+*       !n          command number n, as shown by the history command
+*       !prefix     the newest command starting with prefix
+* reference: a line of user input starting with !
+* return: the command from history, or NULL if there is no matching command
+*/
+char* expandHistoryReference(char* reference) {
+    char* target = reference + 1;  // skip the !
+    int entryIndex = -1;
+
+    indexHistory();
+
+    if (isEqualString(target, "!")) {
+        // !! refers to the previous command
+        entryIndex = GLOBAL_history.entryCount - 1;
+    } else if (*target != '\0' && strspn(target, "0123456789") == strlen(target)) {
+        // !n refers to command number n
+        entryIndex = atoi(target) - 1;
+
+        if (entryIndex >= GLOBAL_history.entryCount) {
+            entryIndex = -1;
+        }
+    } else if (*target != '\0') {
+        entryIndex = findHistoryByPrefix(target, GLOBAL_history.entryCount);
+    }
+
+    if (entryIndex < 0) {
+        fprintf(stderr, "%s: event not found\n", reference);
+        fflush(NULL);
+
+        return NULL;
+    }
+
+    return copyHistoryEntry(entryIndex);
+}
+
+
+/*
+* Prints one history entry with its number
+*/
+static void printHistoryEntry(int entryIndex) {
+    struct HistoryEntry* entry = &GLOBAL_history.entries[entryIndex];
+    printf("%5d  %.*s\n", entryIndex + 1, entry->length, entry->text);
+
+    return;
+}
+
+
+/*
+* Compares two history entry indexes so newer entries sort first, for qsort()
+*/
+static int compareHistoryRecency(const void* entryIndex1, const void* entryIndex2) {
+    return *(const int*) entryIndex2 - *(const int*) entryIndex1;
+}
+
+
+/*
+* Prints the command history, without duplicates
+*       history             prints every command, oldest first
+*       history n           prints the newest n commands
+*       history -s prefix   prints the commands starting with prefix, newest first
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleHistoryCommand(struct CommandLine* commandLine) {
+    indexHistory();
+
+    if (commandLine->argCount >= 2 && isEqualString(commandLine->args[0], "-s")) {
+        // search the prefix index
+        char* prefix = commandLine->args[1];
+        int prefixLength = strlen(prefix);
+        int matchCount = 0;
+
+        sortHistory();
+        mergeUnsortedHistory();
+
+        int firstPosition = findSortedHistoryPosition(prefix, prefixLength);
+
+        // print the matches, newest first
+        matchCount = findSortedPrefixEnd(prefix, prefixLength) - firstPosition;
+        int* matches = malloc((matchCount + 1) * sizeof(int));
+        memcpy(matches, &GLOBAL_history.sortedEntries[firstPosition], matchCount * sizeof(int));
+        qsort(matches, matchCount, sizeof(int), compareHistoryRecency);
+
+        for (int index = 0; index < matchCount; ++index) {
+            printHistoryEntry(matches[index]);
+        }
+
+        free(matches);
+    } else {
+        // print the newest n unique entries (all of them by default), oldest first
+        int printCount = commandLine->argCount >= 1 ? atoi(commandLine->args[0]) : GLOBAL_history.uniqueCount;
+        int firstIndex = GLOBAL_history.entryCount;
+
+        // find the first entry to print by counting back from the newest
+        for (int skipped = 0; firstIndex > 0 && skipped < printCount; ) {
+            --firstIndex;
+
+            if (!GLOBAL_history.entries[firstIndex].isSuperseded) {
+                ++skipped;
+            }
+        }
+
+        for (int index = firstIndex; index < GLOBAL_history.entryCount; ++index) {
+            if (!GLOBAL_history.entries[index].isSuperseded) {
+                printHistoryEntry(index);
+            }
+        }
+    }
+
+    fflush(NULL);
+
+    return;
+}
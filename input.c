@@ -0,0 +1,276 @@
+// Reading commands and here-documents from the user
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* smallsh's buffer for input that isn't from a terminal, like a script. It's read with
+* read() rather than through the stdin stream, so smallsh can tell whether a whole line
+* is already waiting before it blocks for more (and runs scheduled commands meanwhile)
+*/
+struct InputBuffer {
+    char data[INPUT_BUFFER_SIZE];
+    int start;  // first byte not yet taken
+    int end;  // end of the bytes read so far
+};
+
+
+static struct InputBuffer GLOBAL_inputBuffer;
+
+
+/*
+* prints the special command prompt string to the terminal
+*/
+void printCommandPrompt() {
+    printToTerminal(COMMAND_PROMPT, false);
+
+    return;
+}
+
+
+/*
+* prints any given string to the terminal, followed by a newline
+* flushes the output buffer
+* text: one line to print
+* isError: if true, prints with perror() instead of printf()
+*/
+void printToTerminal(const char* text, bool isError) {
+    if (isError) {
+        // print error to standard error
+        perror(text);
+    } else {
+        // print normal text to terminal
+        printf("%s", text);
+    }
+
+    // flush output buffer (output text may not reach the screen until this happens)
+    fflush(NULL);
+
+    return;
+}
+
+
+/*
+* Checks whether smallsh's input comes from a terminal
+* return: true if stdin was a terminal when smallsh first checked
+*/
+static bool isTerminalInput() {
+    static int isTerminal = -1;
+
+    if (isTerminal == -1) {
+        isTerminal = isatty(STDIN_FILENO);
+    }
+
+    return isTerminal;
+}
+
+
+/*
+* Reads the next line of smallsh's own input, like getline()
+* Builtins that read stdin (when it isn't redirected) use this too, so they get the
+* lines after the command even if smallsh has already read them into its buffer
+* line: set to a buffer holding the line, with its newline if it had one (free it after)
+* capacity: the size of *line's buffer
+* return: the line's length, or -1 at end of input
+*/
+ssize_t getInputLine(char** line, size_t* capacity) {
+    struct InputBuffer* buffer = &GLOBAL_inputBuffer;
+    size_t length = 0;
+
+    // a terminal's lines come one at a time anyway
+    if (isTerminalInput()) {
+        ssize_t result = getline(line, capacity, stdin);
+
+        // ctrl+D only ends what a builtin was reading; smallsh goes on reading commands
+        if (result == -1) {
+            clearerr(stdin);
+        }
+
+        return result;
+    }
+
+    while (true) {
+        // refill the buffer once it's used up
+        if (buffer->start == buffer->end) {
+            ssize_t count;
+
+            while ((count = read(STDIN_FILENO, buffer->data, INPUT_BUFFER_SIZE)) == -1 && errno == EINTR) {
+            }
+
+            if (count <= 0) {
+                break;
+            }
+
+            buffer->start = 0;
+            buffer->end = count;
+        }
+
+        // take the rest of the line, or all of the buffer if the line goes on past it
+        char* chunk = buffer->data + buffer->start;
+        char* lineEnd = memchr(chunk, '\n', buffer->end - buffer->start);
+        size_t chunkLength = lineEnd ? (size_t) (lineEnd + 1 - chunk) : (size_t) (buffer->end - buffer->start);
+
+        if (!*line || length + chunkLength + 1 > *capacity) {
+            *capacity = (length + chunkLength + 1) * 2;
+            *line = realloc(*line, *capacity);
+        }
+
+        memcpy(*line + length, chunk, chunkLength);
+        length += chunkLength;
+        (*line)[length] = '\0';
+        buffer->start += chunkLength;
+
+        if (lineEnd) {
+            break;
+        }
+    }
+
+    return length > 0 ? (ssize_t) length : -1;
+}
+
+
+/*
+* Reads one line of input
+* Input from a terminal is read with the line editor; other input is read from
+* smallsh's input buffer
+* prompt: the prompt, which must already be printed
+* return: the line (without a newline), or NULL at end of input
+*/
+static char* readInputLine(const char* prompt) {
+    char* userInput = NULL;
+    size_t capacity = 0;
+    struct InputBuffer* buffer = &GLOBAL_inputBuffer;
+
+    if (isTerminalInput()) {
+        // get edited string from user
+        return readEditedLine(prompt);
+    }
+
+    // run scheduled commands while waiting for input (unless a whole line is already buffered);
+    // a signal just means wait again, since blocking in read() would hold up the timers
+    if (!memchr(buffer->data + buffer->start, '\n', buffer->end - buffer->start)) {
+        int waitResult;
+
+        while ((waitResult = waitForInputOrTimer(STDIN_FILENO)) != 1) {
+            if (waitResult == 0) {
+                runDueTimers();
+                reapAll();
+            }
+        }
+    }
+
+    if (getInputLine(&userInput, &capacity) == -1) {
+        free(userInput);
+        return NULL;
+    }
+
+    // remove the newline, and cut off anything past the longest line smallsh takes
+    userInput[strcspn(userInput, "\n")] = 0;
+
+    if (strlen(userInput) > MAX_INPUT_LENGTH) {
+        userInput[MAX_INPUT_LENGTH] = '\0';
+    }
+
+    return userInput;
+}
+
+
+/*
+* gets a new command from the user
+* Exits smallsh at the end of input
+* return: user input, expanded with smallsh pid in place of $$
+*/
+char* getUserCommandString() {
+    char* userInput = readInputLine(COMMAND_PROMPT);
+
+    // there's nothing left to run
+    if (!userInput) {
+        handleExitCommand();
+    }
+
+    // replace a history reference (like !! or !prefix) with the command it refers to,
+    // and show the user which command that was
+    if (userInput[0] == '!' && userInput[1] != '\0') {
+        char* historyCommand = expandHistoryReference(userInput);
+        free(userInput);
+
+        if (!historyCommand) {
+            // there's no such command, so treat this as empty input
+            return calloc(1, sizeof(char));
+        }
+
+        userInput = historyCommand;
+        printf("%s\n", userInput);
+        fflush(NULL);
+    }
+
+    // record the command as typed, so $$ expands to the pid of whichever smallsh reruns it
+    // (only commands someone typed, not every line of a script)
+    if (isTerminalInput()) {
+        addHistoryEntry(userInput);
+    }
+
+    // return input, expanded with smallsh pid in place of $$
+    char* expandedInput = expandPidVariable(userInput);
+    free(userInput);
+
+    return expandedInput;
+}
+
+
+/*
+* Reads the lines of a here-document (started by <<) into a command line
+* Lines are read until one matches the delimiter exactly. $$ is expanded in each line
+* commandLine: pointer to a CommandLine struct with a hereDocDelimiter
+*/
+void readHereDocument(struct CommandLine* commandLine) {
+    int capacity = 256;
+    int length = 0;
+    char* text = calloc(capacity, sizeof(char));
+
+    while (true) {
+        // only prompt someone who is typing the lines
+        if (isTerminalInput()) {
+            printToTerminal(HERE_DOCUMENT_PROMPT, false);
+        }
+
+        char* line = readInputLine(HERE_DOCUMENT_PROMPT);
+
+        if (!line) {
+            fprintf(stderr, "here-document ended by end of input (wanted '%s')\n", commandLine->hereDocDelimiter);
+            fflush(NULL);
+            break;
+        }
+
+        if (isEqualString(line, commandLine->hereDocDelimiter)) {
+            free(line);
+            break;
+        }
+
+        // add the expanded line and its newline
+        char* expandedLine = expandPidVariable(line);
+        int lineLength = strlen(expandedLine);
+
+        while (length + lineLength + 2 > capacity) {
+            capacity *= 2;
+            text = realloc(text, capacity);
+        }
+
+        memcpy(text + length, expandedLine, lineLength);
+        length += lineLength;
+        text[length++] = '\n';
+        text[length] = '\0';
+
+        free(line);
+        free(expandedLine);
+    }
+
+    free(commandLine->hereDocument);
+    commandLine->hereDocument = text;
+    commandLine->hereDocumentLength = length;
+
+    free(commandLine->hereDocDelimiter);
+    commandLine->hereDocDelimiter = NULL;
+
+    return;
+}
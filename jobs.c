@@ -0,0 +1,417 @@
+// Tracking and reaping background jobs
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+// globals used to track PIDs of background child processes
+// syntax reminder from https://stackoverflow.com/a/201116/14257952
+pid_t GLOBAL_backgroundChildrenPids[MAX_BG_CHILDREN] = {0};
+struct timespec GLOBAL_backgroundChildrenStartTimes[MAX_BG_CHILDREN] = {{0}};  // CLOCK_MONOTONIC
+
+
+/*
+* adds a PID to the global array tracking background child PIDs
+* pid_in: pid to add to the global list
+* return: true if it was added; false if the list is full
+*/
+bool registerNewBgChildPid(pid_t pid_in) {
+    // add this process id to the list, at the first 0
+    for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+        // find the spot in the array with the first 0
+        if (GLOBAL_backgroundChildrenPids[index] == 0) {
+            // add the pid to the list, noting when it started
+            GLOBAL_backgroundChildrenPids[index] = pid_in;
+            clock_gettime(CLOCK_MONOTONIC, &GLOBAL_backgroundChildrenStartTimes[index]);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/*
+* Removes a PID from the global array tracking background child PIDs
+* If the provided PID isn't in the array, nothing happens
+* pid_in: pid to remove from the global list
+*/
+void unregisterBgChildPid(pid_t pid_in) {
+    // remove this process id from the list, if found
+    for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+        // find the spot in the array with the given pid
+        if (GLOBAL_backgroundChildrenPids[index] == pid_in) {
+            // Remove the pid from the list.
+            // No need to shift the remaining elements, because the function that adds
+            // elements will add in the first 0 spot
+            GLOBAL_backgroundChildrenPids[index] = 0;
+
+            break;
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Finds a PID in the global array tracking background child PIDs
+* pid_in: pid to look for in the global list
+* return: the PID's index in the global list, or -1 if it isn't there
+*/
+static int findBgChildIndex(pid_t pid_in) {
+    // check the list for this process id
+    for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+        // find the spot in the array with the given pid
+        if (GLOBAL_backgroundChildrenPids[index] == pid_in) {
+            // pid was found
+            return index;
+        }
+    }
+
+    // pid was not found in the above loop
+    return -1;
+}
+
+
+/*
+* Checks whether a PID is in the global array tracking background child PIDs
+* pid_in: pid to check for in the global list
+* return: true if the given PID is in the gloabl list; false if not
+*/
+bool isTrackedBgChild(pid_t pid_in) {
+    return findBgChildIndex(pid_in) != -1;
+}
+
+
+/*
+* Checks whether there's room in the global array for another background child,
+* reaping any that have finished first if it's full
+* return: true if another background child can be registered
+*/
+bool hasRoomForBgChild() {
+    if (findBgChildIndex(0) == -1) {
+        reapAll();
+    }
+
+    return findBgChildIndex(0) != -1;
+}
+
+
+/*
+* Gets the time elapsed since an earlier time
+* start: a CLOCK_MONOTONIC time
+* return: nanoseconds elapsed since start
+*/
+long long getElapsedNanoseconds(struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000000000LL + (now.tv_nsec - start->tv_nsec);
+}
+
+
+/*
+* does everything that needs to be done by a new child process
+*/
+void handleNewBgChild() {
+    // background children must handle signals differently (per specs)
+    registerNewBgChildSignals();
+
+    return;
+}
+
+
+/*
+* Stops tracking a background job that has ended, logs it, and adds its completion notice
+* to a buffer, so several notices can be printed together
+* index: the job's spot in the global array
+* terminationStatus: the job's status from waitpid()
+* notices: buffer of notices, which must have room for MAX_JOB_NOTICE_LENGTH more chars
+* return: the job's exit value, or the number of the signal that terminated it
+*/
+static int finishBgChild(int index, int terminationStatus, char* notices) {
+    pid_t childPid = GLOBAL_backgroundChildrenPids[index];
+    long long duration = getElapsedNanoseconds(&GLOBAL_backgroundChildrenStartTimes[index]);
+    char* noticeEnd = notices + strlen(notices);
+    int statusValue;
+
+    // stop tracking it, so its spot can be reused
+    GLOBAL_backgroundChildrenPids[index] = 0;
+
+    // add a notice based on termination status
+    if (WIFEXITED(terminationStatus)) {
+        // process exited normally
+        statusValue = WEXITSTATUS(terminationStatus);
+        logJobEvent(JOB_EXIT, childPid, statusValue, true, duration, NULL);
+        sprintf(noticeEnd, "background pid %d is done: exit value %d\n", childPid, statusValue);
+    } else {
+        // Process was terminated by a signal.
+        // Give the number of the signal that terminated the process
+        statusValue = WTERMSIG(terminationStatus);
+        logJobEvent(JOB_SIGNAL, childPid, statusValue, true, duration, NULL);
+        sprintf(noticeEnd, "background pid %d is done: terminated by signal %d\n", childPid, statusValue);
+    }
+
+    return statusValue;
+}
+
+
+/*
+* Prints a buffer of completion notices with a single write, then empties the buffer
+* notices: buffer filled by finishBgChild()
+*/
+static void printJobNotices(char* notices) {
+    size_t noticesLength = strlen(notices);
+
+    if (noticesLength > 0) {
+        write(STDOUT_FILENO, notices, noticesLength);
+        notices[0] = '\0';
+    }
+
+    return;
+}
+
+
+/*
+* Reaps all zombie processes and displays a notice of termination status
+*/
+void reapAll() {
+    pid_t childPid;
+    int terminationStatus;
+    char notices[MAX_BG_CHILDREN * MAX_JOB_NOTICE_LENGTH] = "";
+
+    // check status of all tracked background processes 
+    // (NOT checking foreground here, because they need to be checked for status command)
+    for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+        childPid = GLOBAL_backgroundChildrenPids[index];
+
+        // only reap tracked PIDs; this was a background process that just ended if waitpid finds it
+        if (childPid > 0 && waitpid(childPid, &terminationStatus, WNOHANG) > 0) {
+            finishBgChild(index, terminationStatus, notices);
+        }
+    }
+
+    // print every notice at once
+    printJobNotices(notices);
+
+    // get exit status of all terminated background processes
+    // while (childPid = waitpid(-1, terminationStatus, WNOHANG) != -1) {
+    //     // zombie was reaped by waitpid
+    // }
+
+    return;
+}
+
+
+/*
+* Opens a pidfd for a child process, which becomes readable when the child ends
+* pid: the child's PID
+* return: the pidfd (close-on-exec), or -1 if the kernel doesn't support pidfds
+*/
+int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return syscall(SYS_pidfd_open, pid, 0);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
+/*
+* Blocks until background jobs end, without busy-waiting
+* Each job gets a pidfd, and poll() sleeps until one of them is readable. On kernels
+* without pidfds, waitid() sleeps until any child ends instead.
+* Jobs that end while waiting are reaped, and their notices are printed together
+* after each wakeup. Scheduled commands run as they come due, except without pidfds,
+* where they wait until a job ends
+* targetPids: the jobs to wait for (all of them must be tracked)
+* statuses: filled with each job's exit value or terminating signal
+* targetCount: number of jobs in targetPids
+* isWaitForAny: if true, return as soon as any of the jobs ends
+* return: index in targetPids of the last job to end, or -1 if interrupted by ctrl+C
+*/
+static int waitForBgChildren(pid_t* targetPids, int* statuses, int targetCount, bool isWaitForAny) {
+    struct pollfd pollFDs[MAX_BG_CHILDREN + 1];  // a pidfd per job, then the timerfd
+    char notices[MAX_BG_CHILDREN * MAX_JOB_NOTICE_LENGTH] = "";
+    bool isUsingPidfds = true;
+    int remainingCount = targetCount;
+    int lastEndedIndex = -1;
+    int terminationStatus;
+
+    // open a pidfd per job (they still work for jobs that are already zombies)
+    for (int target = 0; target < targetCount; ++target) {
+        pollFDs[target].fd = openPidfd(targetPids[target]);
+        pollFDs[target].events = POLLIN;
+
+        if (pollFDs[target].fd == -1) {
+            isUsingPidfds = false;
+        }
+    }
+
+    pollFDs[targetCount].fd = getTimerFD();
+    pollFDs[targetCount].events = POLLIN;
+
+    // Ctrl+C stops the wait, but ctrl+Z (which only toggles foreground-only mode) doesn't
+    GLOBAL_receivedSIGINT = 0;
+
+    while (remainingCount > 0) {
+        // sleep until a job ends
+        int waitResult;
+        siginfo_t childInfo;
+
+        if (isUsingPidfds) {
+            waitResult = poll(pollFDs, targetCount + 1, -1);
+        } else {
+            // WNOWAIT leaves the child to be reaped below, with the rest
+            childInfo.si_pid = 0;
+            waitResult = waitid(P_ALL, 0, &childInfo, WEXITED | WNOWAIT);
+        }
+
+        if (waitResult == -1) {
+            if (errno == EINTR && !GLOBAL_receivedSIGINT) {
+                continue;
+            }
+
+            // interrupted (or no children left, which shouldn't happen)
+            lastEndedIndex = -1;
+            break;
+        }
+
+        if (isUsingPidfds && (pollFDs[targetCount].revents & POLLIN)) {
+            runDueTimers();
+        }
+
+        // reap the jobs that have ended
+        for (int target = 0; target < targetCount; ++target) {
+            int index = targetPids[target] > 0 ? findBgChildIndex(targetPids[target]) : -1;
+
+            if (index != -1 && waitpid(targetPids[target], &terminationStatus, WNOHANG) > 0) {
+                statuses[target] = finishBgChild(index, terminationStatus, notices);
+                targetPids[target] = 0;
+                lastEndedIndex = target;
+                --remainingCount;
+
+                // poll() skips negative fds
+                if (pollFDs[target].fd != -1) {
+                    close(pollFDs[target].fd);
+                    pollFDs[target].fd = -1;
+                }
+            }
+        }
+
+        if (!isUsingPidfds) {
+            // waitid() wakes up for any child, so a job that isn't being waited for must be
+            // reaped too, or it would wake waitid() again right away
+            int index = childInfo.si_pid > 0 ? findBgChildIndex(childInfo.si_pid) : -1;
+
+            if (index != -1 && waitpid(childInfo.si_pid, &terminationStatus, WNOHANG) > 0) {
+                finishBgChild(index, terminationStatus, notices);
+            } else if (index == -1 && childInfo.si_pid > 0) {
+                waitpid(childInfo.si_pid, &terminationStatus, WNOHANG);
+            }
+        }
+
+        // print every notice from this wakeup at once
+        printJobNotices(notices);
+
+        if (isWaitForAny && lastEndedIndex != -1) {
+            break;
+        }
+    }
+
+    // close the pidfds of jobs that are still running
+    for (int target = 0; target < targetCount; ++target) {
+        if (pollFDs[target].fd != -1) {
+            close(pollFDs[target].fd);
+        }
+    }
+
+    return lastEndedIndex;
+}
+
+
+/*
+* Waits for background jobs to end
+* wait             waits for every job
+* wait PID...      waits for the given jobs; the status is the last one's
+* wait -n [PID...] waits for any one of the jobs (or of the given jobs)
+* The status command reports the job's exit value (127 if the last PID isn't a job of
+* smallsh, or 128 + SIGINT if the wait was interrupted by ctrl+C)
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleWaitCommand(struct CommandLine* commandLine) {
+    pid_t targetPids[MAX_BG_CHILDREN];
+    int statuses[MAX_BG_CHILDREN];
+    int targetCount = 0;
+    bool isWaitForAny = false;
+    bool isLastPidValid = true;
+    bool hasPidArgs = false;
+
+    // collect the jobs to wait for
+    for (int argIndex = 0; argIndex < commandLine->argCount; ++argIndex) {
+        char* arg = commandLine->args[argIndex];
+        pid_t pid;
+        bool isDuplicate = false;
+
+        if (isEqualString(arg, "-n")) {
+            isWaitForAny = true;
+            continue;
+        }
+
+        hasPidArgs = true;
+        pid = atoi(arg);
+        isLastPidValid = pid > 0 && isTrackedBgChild(pid);
+
+        if (!isLastPidValid) {
+            fprintf(stderr, "wait: pid %s is not a background job of smallsh\n", arg);
+            fflush(stderr);
+            continue;
+        }
+
+        // waiting for the same job twice would count it twice
+        for (int target = 0; target < targetCount; ++target) {
+            if (targetPids[target] == pid) {
+                isDuplicate = true;
+            }
+        }
+
+        if (!isDuplicate) {
+            targetPids[targetCount] = pid;
+            ++targetCount;
+        }
+    }
+
+    // with no PIDs given, wait for every job
+    if (!hasPidArgs) {
+        for (int index = 0; index < MAX_BG_CHILDREN; ++index) {
+            if (GLOBAL_backgroundChildrenPids[index] > 0) {
+                targetPids[targetCount] = GLOBAL_backgroundChildrenPids[index];
+                ++targetCount;
+            }
+        }
+    }
+
+    if (targetCount == 0) {
+        // nothing to wait for; wait -n with no jobs fails like an unknown PID
+        GLOBAL_lastForegroundChildStatus = (isWaitForAny || !isLastPidValid) ? 127 : 0;
+        return;
+    }
+
+    int lastEndedIndex = waitForBgChildren(targetPids, statuses, targetCount, isWaitForAny);
+
+    // update status
+    if (lastEndedIndex == -1) {
+        GLOBAL_lastForegroundChildStatus = 128 + SIGINT;
+    } else if (!isLastPidValid) {
+        GLOBAL_lastForegroundChildStatus = 127;
+    } else if (hasPidArgs && !isWaitForAny) {
+        // like other shells, wait PID... reports the last PID listed
+        GLOBAL_lastForegroundChildStatus = statuses[targetCount - 1];
+    } else {
+        GLOBAL_lastForegroundChildStatus = statuses[lastEndedIndex];
+    }
+
+    return;
+}
@@ -0,0 +1,1058 @@
+// The interactive line editor and its tab completion caches
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* A node in a trie of words used for tab completion
+* Nodes are never removed; a word is removed by dropping its refCount to 0
+*/
+struct TrieNode {
+    char character;
+    int refCount;  // how many sources provide the word ending here (0 if no word ends here)
+    int wordCount;  // number of words ending at this node or below it
+    struct TrieNode* firstChild;  // children are kept in sorted order
+    struct TrieNode* nextSibling;
+};
+
+
+/*
+* A directory in PATH, with the executables that were in it when it was last scanned
+*/
+struct PathDirectory {
+    char* path;
+    struct timespec modifiedTime;  // the directory's mtime when it was last scanned
+    char** names;
+    int nameCount;
+};
+
+
+/*
+* The cached contents of a directory, used to complete file paths
+*/
+struct DirectoryListing {
+    char* path;
+    struct timespec modifiedTime;  // the directory's mtime when it was listed
+    struct TrieNode* names;  // subdirectory names end with '/'
+};
+
+
+/*
+* The state of the line being edited at the prompt
+*/
+struct LineEditor {
+    const char* prompt;
+    char buffer[MAX_INPUT_LENGTH + 1];
+    int length;
+    int cursor;
+    int historyIndex;  // entry shown while browsing history (entryCount when not browsing)
+    char* savedLine;  // the line that was being edited before browsing history
+    bool wasTab;  // whether the previous key was tab, so a second tab lists the completions
+};
+
+
+// tab completion caches. The command trie holds builtins and every executable in PATH
+static struct TrieNode GLOBAL_commandTrie = {0};
+static struct PathDirectory* GLOBAL_pathDirectories = NULL;
+static int GLOBAL_pathDirectoryCount = 0;
+static char* GLOBAL_cachedPath = NULL;  // the value of PATH that GLOBAL_pathDirectories came from
+static struct DirectoryListing GLOBAL_directoryListings[MAX_CACHED_DIRECTORIES] = {{0}};
+static int GLOBAL_nextDirectoryListing = 0;  // the cached listing to replace next (round robin)
+
+
+/*
+* Finds a child of a trie node, optionally creating it
+* node: the parent node
+* character: the child's character
+* create: if true, the child is created (in sorted order) if it doesn't exist
+* return: the child, or NULL if it doesn't exist and create is false
+*/
+static struct TrieNode* findTrieChild(struct TrieNode* node, char character, bool create) {
+    struct TrieNode** childLink = &node->firstChild;
+
+    // children are sorted, so stop at the first one that isn't less than character
+    while (*childLink && (unsigned char) (*childLink)->character < (unsigned char) character) {
+        childLink = &(*childLink)->nextSibling;
+    }
+
+    if (*childLink && (*childLink)->character == character) {
+        return *childLink;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    struct TrieNode* child = calloc(1, sizeof(struct TrieNode));
+    child->character = character;
+    child->nextSibling = *childLink;
+    *childLink = child;
+
+    return child;
+}
+
+
+/*
+* Finds the node for a prefix in a trie
+* return: the node at the end of the prefix, or NULL if no word starts with the prefix
+*/
+static struct TrieNode* findTrieNode(struct TrieNode* root, const char* prefix) {
+    struct TrieNode* node = root;
+
+    while (node && *prefix != '\0') {
+        node = findTrieChild(node, *prefix, false);
+        ++prefix;
+    }
+
+    return node;
+}
+
+
+/*
+* Adds a word to a trie, or adds another reference to it if it's already there
+*/
+static void insertTrieWord(struct TrieNode* root, const char* word) {
+    struct TrieNode* node = root;
+
+    for (const char* character = word; *character != '\0'; ++character) {
+        node = findTrieChild(node, *character, true);
+    }
+
+    ++node->refCount;
+
+    // the word is new, so count it at every node along its path
+    if (node->refCount == 1) {
+        node = root;
+        ++node->wordCount;
+
+        for (const char* character = word; *character != '\0'; ++character) {
+            node = findTrieChild(node, *character, false);
+            ++node->wordCount;
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Removes one reference to a word from a trie; the word is gone once nothing refers to it
+*/
+static void removeTrieWord(struct TrieNode* root, const char* word) {
+    struct TrieNode* node = findTrieNode(root, word);
+
+    if (!node || node->refCount == 0) {
+        return;
+    }
+
+    --node->refCount;
+
+    // the word is gone, so stop counting it at every node along its path
+    if (node->refCount == 0) {
+        node = root;
+        --node->wordCount;
+
+        for (const char* character = word; *character != '\0'; ++character) {
+            node = findTrieChild(node, *character, false);
+            --node->wordCount;
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Frees a trie node and everything below it
+*/
+static void freeTrie(struct TrieNode* node) {
+    while (node) {
+        struct TrieNode* nextSibling = node->nextSibling;
+        freeTrie(node->firstChild);
+        free(node);
+        node = nextSibling;
+    }
+
+    return;
+}
+
+
+/*
+* Prints every word below a trie node, in sorted order, as columns that fit the terminal
+* node: the node for the prefix the words share
+* prefix: the text of that prefix, which is included in the printed words
+*/
+static void printTrieWords(struct TrieNode* node, const char* prefix) {
+    int wordCount = node->wordCount;
+    char** words = calloc(wordCount + 1, sizeof(char*));
+    int foundCount = 0;
+    int maxLength = 0;
+    // the words are file and command names (at most NAME_MAX, plus a '/' for a directory),
+    // so a completion word always fits in an input line
+    char* word = calloc(MAX_INPUT_LENGTH + 1, sizeof(char));
+    strcpy(word, prefix);
+
+    // Walk the trie depth first without recursion. Each stack entry is the node
+    // to visit next at that depth
+    struct TrieNode** stack = calloc(MAX_INPUT_LENGTH + 1, sizeof(struct TrieNode*));
+    int baseDepth = strlen(prefix);
+    int depth = baseDepth;
+
+    if (node->refCount > 0) {
+        words[foundCount++] = strdup(word);
+    }
+    stack[depth] = node->firstChild;
+
+    while (depth >= baseDepth && foundCount < wordCount) {
+        struct TrieNode* current = stack[depth];
+
+        if (!current) {
+            // done with this depth
+            --depth;
+            if (depth >= baseDepth) {
+                stack[depth] = stack[depth]->nextSibling;
+            }
+            continue;
+        }
+
+        if (current->wordCount == 0 || depth >= MAX_INPUT_LENGTH - 1) {
+            // every word below here was removed (or is too long to ever be typed)
+            stack[depth] = current->nextSibling;
+            continue;
+        }
+
+        word[depth] = current->character;
+        word[depth + 1] = '\0';
+
+        if (current->refCount > 0) {
+            words[foundCount++] = strdup(word);
+        }
+
+        ++depth;
+        stack[depth] = current->firstChild;
+    }
+
+    // lay the words out in columns
+    for (int index = 0; index < foundCount; ++index) {
+        int length = strlen(words[index]);
+        maxLength = length > maxLength ? length : maxLength;
+    }
+
+    struct winsize terminalSize;
+    int terminalWidth = 80;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &terminalSize) == 0 && terminalSize.ws_col > 0) {
+        terminalWidth = terminalSize.ws_col;
+    }
+
+    int columnCount = terminalWidth / (maxLength + 2);
+    columnCount = columnCount > 0 ? columnCount : 1;
+    int rowCount = (foundCount + columnCount - 1) / columnCount;
+
+    printf("\n");
+    for (int row = 0; row < rowCount; ++row) {
+        for (int column = 0; column < columnCount; ++column) {
+            int index = column * rowCount + row;
+
+            if (index < foundCount) {
+                printf("%-*s", maxLength + 2, words[index]);
+            }
+        }
+        printf("\n");
+    }
+    fflush(NULL);
+
+    for (int index = 0; index < foundCount; ++index) {
+        free(words[index]);
+    }
+    free(words);
+    free(word);
+    free(stack);
+
+    return;
+}
+
+
+/*
+* Lists the executables in one PATH directory and adds them to the command trie
+* directory: a PATH directory with no names currently in the trie
+*/
+static void scanPathDirectory(struct PathDirectory* directory) {
+    DIR* directoryStream = opendir(directory->path);
+    struct dirent* directoryEntry;
+    int capacity = 0;
+
+    if (!directoryStream) {
+        return;
+    }
+
+    while ((directoryEntry = readdir(directoryStream)) != NULL) {
+        char* name = directoryEntry->d_name;
+        struct stat fileInfo;
+
+        if (directoryEntry->d_type == DT_DIR || name[0] == '.') {
+            continue;
+        }
+
+        // links (and files on file systems that don't report types) might be directories
+        if (directoryEntry->d_type != DT_REG) {
+            if (fstatat(dirfd(directoryStream), name, &fileInfo, 0) == -1 || S_ISDIR(fileInfo.st_mode)) {
+                continue;
+            }
+        }
+
+        if (faccessat(dirfd(directoryStream), name, X_OK, 0) == -1) {
+            continue;
+        }
+
+        // remember the name, so it can be removed from the trie if it's deleted later
+        if (directory->nameCount == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            directory->names = realloc(directory->names, capacity * sizeof(char*));
+        }
+        directory->names[directory->nameCount] = strdup(name);
+        insertTrieWord(&GLOBAL_commandTrie, name);
+        ++directory->nameCount;
+    }
+
+    closedir(directoryStream);
+
+    return;
+}
+
+
+/*
+* Removes one PATH directory's executables from the command trie
+*/
+static void forgetPathDirectory(struct PathDirectory* directory) {
+    for (int index = 0; index < directory->nameCount; ++index) {
+        removeTrieWord(&GLOBAL_commandTrie, directory->names[index]);
+        free(directory->names[index]);
+    }
+
+    free(directory->names);
+    directory->names = NULL;
+    directory->nameCount = 0;
+
+    return;
+}
+
+
+/*
+* Brings the command trie up to date with the executables in PATH
+* Only directories whose mtime changed since they were last scanned are scanned again,
+* so this only costs a stat() per directory when nothing changed.
+* (Making an existing file executable doesn't change its directory's mtime, so
+* that isn't noticed until something else in the directory changes)
+*/
+static void refreshCommandTrie() {
+    char* path = getenv("PATH") ? getenv("PATH") : "";
+
+    // builtins are always in the trie
+    if (!GLOBAL_cachedPath) {
+        for (int index = 0; GLOBAL_builtinCommands[index]; ++index) {
+            insertTrieWord(&GLOBAL_commandTrie, GLOBAL_builtinCommands[index]);
+        }
+    }
+
+    // start over if PATH itself changed
+    if (!GLOBAL_cachedPath || !isEqualString(path, GLOBAL_cachedPath)) {
+        for (int index = 0; index < GLOBAL_pathDirectoryCount; ++index) {
+            forgetPathDirectory(&GLOBAL_pathDirectories[index]);
+            free(GLOBAL_pathDirectories[index].path);
+        }
+        free(GLOBAL_pathDirectories);
+        free(GLOBAL_cachedPath);
+
+        GLOBAL_cachedPath = strdup(path);
+        GLOBAL_pathDirectoryCount = 1;
+        for (char* character = path; *character != '\0'; ++character) {
+            GLOBAL_pathDirectoryCount += *character == ':';
+        }
+        GLOBAL_pathDirectories = calloc(GLOBAL_pathDirectoryCount, sizeof(struct PathDirectory));
+
+        // split PATH on ':' (an empty entry means the current directory)
+        char* pathCopy = strdup(path);
+        char* entryStart = pathCopy;
+        int directoryCount = 0;
+        while (entryStart) {
+            char* entryEnd = strchr(entryStart, ':');
+            if (entryEnd) {
+                *entryEnd = '\0';
+            }
+
+            GLOBAL_pathDirectories[directoryCount].path = strdup(*entryStart != '\0' ? entryStart : ".");
+            ++directoryCount;
+
+            entryStart = entryEnd ? entryEnd + 1 : NULL;
+        }
+        GLOBAL_pathDirectoryCount = directoryCount;
+        free(pathCopy);
+    }
+
+    // rescan only the directories that changed
+    for (int index = 0; index < GLOBAL_pathDirectoryCount; ++index) {
+        struct PathDirectory* directory = &GLOBAL_pathDirectories[index];
+        struct stat directoryInfo;
+
+        if (stat(directory->path, &directoryInfo) == -1) {
+            // the directory is gone
+            forgetPathDirectory(directory);
+            memset(&directory->modifiedTime, 0, sizeof(struct timespec));
+            continue;
+        }
+
+        if (directoryInfo.st_mtim.tv_sec != directory->modifiedTime.tv_sec
+                || directoryInfo.st_mtim.tv_nsec != directory->modifiedTime.tv_nsec) {
+            forgetPathDirectory(directory);
+            scanPathDirectory(directory);
+            directory->modifiedTime = directoryInfo.st_mtim;
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Gets a trie of the names in a directory, from the cache if the directory hasn't changed
+* path: the directory to list
+* return: the root of the trie, or NULL if the directory can't be read
+*/
+static struct TrieNode* getDirectoryListing(const char* path) {
+    struct stat directoryInfo;
+    struct DirectoryListing* listing = NULL;
+
+    if (stat(path, &directoryInfo) == -1) {
+        return NULL;
+    }
+
+    // check the cache
+    for (int index = 0; index < MAX_CACHED_DIRECTORIES; ++index) {
+        if (GLOBAL_directoryListings[index].path && isEqualString(GLOBAL_directoryListings[index].path, (char*) path)) {
+            listing = &GLOBAL_directoryListings[index];
+
+            if (directoryInfo.st_mtim.tv_sec == listing->modifiedTime.tv_sec
+                    && directoryInfo.st_mtim.tv_nsec == listing->modifiedTime.tv_nsec) {
+                return listing->names;
+            }
+
+            break;
+        }
+    }
+
+    // not cached (or out of date), so replace the oldest cached listing
+    if (!listing) {
+        listing = &GLOBAL_directoryListings[GLOBAL_nextDirectoryListing];
+        GLOBAL_nextDirectoryListing = (GLOBAL_nextDirectoryListing + 1) % MAX_CACHED_DIRECTORIES;
+        free(listing->path);
+        listing->path = strdup(path);
+    }
+
+    freeTrie(listing->names);
+    listing->names = calloc(1, sizeof(struct TrieNode));
+    listing->modifiedTime = directoryInfo.st_mtim;
+
+    DIR* directoryStream = opendir(path);
+    struct dirent* directoryEntry;
+    char* name = calloc(MAX_FILEPATH_LENGTH + 2, sizeof(char));
+
+    while (directoryStream && (directoryEntry = readdir(directoryStream)) != NULL) {
+        struct stat fileInfo;
+
+        if (isEqualString(directoryEntry->d_name, ".") || isEqualString(directoryEntry->d_name, "..")) {
+            continue;
+        }
+
+        // mark directories with a trailing '/', so completing one leads into it
+        strcpy(name, directoryEntry->d_name);
+        if (directoryEntry->d_type == DT_DIR
+                || ((directoryEntry->d_type == DT_LNK || directoryEntry->d_type == DT_UNKNOWN)
+                    && fstatat(dirfd(directoryStream), name, &fileInfo, 0) == 0 && S_ISDIR(fileInfo.st_mode))) {
+            strcat(name, "/");
+        }
+
+        insertTrieWord(listing->names, name);
+    }
+
+    if (directoryStream) {
+        closedir(directoryStream);
+    }
+    free(name);
+
+    return listing->names;
+}
+
+
+/*
+* Puts the terminal in the mode used by the line editor: input is read one key at a time
+* and isn't echoed. Signal keys (like ctrl+C and ctrl+Z) still send signals
+* originalSettings: set to the terminal settings to restore afterward
+* return: true if the terminal supports this mode
+*/
+static bool enableRawMode(struct termios* originalSettings) {
+    struct termios rawSettings;
+
+    if (tcgetattr(STDIN_FILENO, originalSettings) == -1) {
+        return false;
+    }
+
+    rawSettings = *originalSettings;
+    rawSettings.c_lflag &= ~(ICANON | ECHO | IEXTEN);
+    rawSettings.c_cc[VMIN] = 1;
+    rawSettings.c_cc[VTIME] = 0;
+
+    return tcsetattr(STDIN_FILENO, TCSADRAIN, &rawSettings) == 0;
+}
+
+
+/*
+* Restores the terminal settings from before enableRawMode()
+*/
+static void disableRawMode(struct termios* originalSettings) {
+    tcsetattr(STDIN_FILENO, TCSADRAIN, originalSettings);
+
+    return;
+}
+
+
+// keys the line editor reads from escape sequences, numbered past any char
+enum EditorKey {
+    KEY_TIMER = -3,  // scheduled commands ran, so the line needs redrawing
+    KEY_INTERRUPTED = -2,  // a signal interrupted read()
+    KEY_END_OF_FILE = -1,
+    KEY_ARROW_UP = 1000,
+    KEY_ARROW_DOWN,
+    KEY_ARROW_RIGHT,
+    KEY_ARROW_LEFT,
+    KEY_HOME,
+    KEY_END,
+    KEY_DELETE,
+    KEY_UNKNOWN_SEQUENCE
+};
+
+
+/*
+* Reads one key press, decoding escape sequences for special keys
+* Scheduled commands that come due while waiting are run, after clearing the line
+* for any notices they print
+* return: the char that was read, an EditorKey, KEY_END_OF_FILE, KEY_INTERRUPTED, or KEY_TIMER
+*/
+static int readKey() {
+    unsigned char key;
+    unsigned char sequence[3];
+    struct pollfd input = {.fd = STDIN_FILENO, .events = POLLIN};
+
+    int inputState = waitForInputOrTimer(STDIN_FILENO);
+    if (inputState == -1) {
+        return errno == EINTR ? KEY_INTERRUPTED : KEY_END_OF_FILE;
+    } else if (inputState == 0) {
+        write(STDOUT_FILENO, "\r\x1b[K", 4);
+        runDueTimers();
+        reapAll();
+        return KEY_TIMER;
+    }
+
+    ssize_t result = read(STDIN_FILENO, &key, 1);
+    if (result == -1) {
+        return errno == EINTR ? KEY_INTERRUPTED : KEY_END_OF_FILE;
+    } else if (result == 0) {
+        return KEY_END_OF_FILE;
+    }
+
+    if (key != '\x1b') {
+        return key;
+    }
+
+    // the rest of an escape sequence arrives right away; a lone escape key doesn't
+    if (poll(&input, 1, 50) != 1 || read(STDIN_FILENO, &sequence[0], 1) != 1) {
+        return key;
+    }
+    if (poll(&input, 1, 50) != 1 || read(STDIN_FILENO, &sequence[1], 1) != 1) {
+        return KEY_UNKNOWN_SEQUENCE;
+    }
+
+    if (sequence[0] == '[' && sequence[1] >= '0' && sequence[1] <= '9') {
+        // sequences like ESC [ 3 ~
+        if (poll(&input, 1, 50) != 1 || read(STDIN_FILENO, &sequence[2], 1) != 1 || sequence[2] != '~') {
+            return KEY_UNKNOWN_SEQUENCE;
+        }
+
+        switch (sequence[1]) {
+            case '1': case '7': return KEY_HOME;
+            case '4': case '8': return KEY_END;
+            case '3': return KEY_DELETE;
+            default: return KEY_UNKNOWN_SEQUENCE;
+        }
+    }
+
+    if (sequence[0] == '[' || sequence[0] == 'O') {
+        switch (sequence[1]) {
+            case 'A': return KEY_ARROW_UP;
+            case 'B': return KEY_ARROW_DOWN;
+            case 'C': return KEY_ARROW_RIGHT;
+            case 'D': return KEY_ARROW_LEFT;
+            case 'H': return KEY_HOME;
+            case 'F': return KEY_END;
+        }
+    }
+
+    return KEY_UNKNOWN_SEQUENCE;
+}
+
+
+/*
+* Redraws the prompt and the line being edited, with the cursor in the right place
+* The whole update is sent with one write(), so the line doesn't flicker
+* label: text to show instead of the editor's prompt (NULL for the prompt)
+*/
+static void refreshLine(struct LineEditor* editor, const char* label) {
+    char* output = calloc(MAX_INPUT_LENGTH * 2 + 64, sizeof(char));
+    int outputLength = 0;
+
+    outputLength += sprintf(output + outputLength, "\r%s", label ? label : editor->prompt);
+    memcpy(output + outputLength, editor->buffer, editor->length);
+    outputLength += editor->length;
+
+    // clear anything left over from a longer line, then move back to the cursor
+    outputLength += sprintf(output + outputLength, "\x1b[K");
+    if (editor->length > editor->cursor) {
+        outputLength += sprintf(output + outputLength, "\x1b[%dD", editor->length - editor->cursor);
+    }
+
+    write(STDOUT_FILENO, output, outputLength);
+    free(output);
+
+    return;
+}
+
+
+/*
+* Inserts text at the cursor, if there is room for it
+*/
+static void insertEditorText(struct LineEditor* editor, const char* text, int length) {
+    if (editor->length + length > MAX_INPUT_LENGTH) {
+        write(STDOUT_FILENO, "\a", 1);  // beep
+        return;
+    }
+
+    memmove(&editor->buffer[editor->cursor + length], &editor->buffer[editor->cursor], editor->length - editor->cursor);
+    memcpy(&editor->buffer[editor->cursor], text, length);
+    editor->length += length;
+    editor->cursor += length;
+    editor->buffer[editor->length] = '\0';
+
+    return;
+}
+
+
+/*
+* Deletes the text from start up to (not including) end, leaving the cursor at start
+*/
+static void deleteEditorText(struct LineEditor* editor, int start, int end) {
+    if (start < 0 || end > editor->length || start >= end) {
+        return;
+    }
+
+    memmove(&editor->buffer[start], &editor->buffer[end], editor->length - end);
+    editor->length -= end - start;
+    editor->cursor = start;
+    editor->buffer[editor->length] = '\0';
+
+    return;
+}
+
+
+/*
+* Replaces the whole line with the given text, with the cursor at the end
+*/
+static void setEditorText(struct LineEditor* editor, const char* text, int length) {
+    length = length < MAX_INPUT_LENGTH ? length : MAX_INPUT_LENGTH;
+    memcpy(editor->buffer, text, length);
+    editor->buffer[length] = '\0';
+    editor->length = length;
+    editor->cursor = length;
+
+    return;
+}
+
+
+/*
+* Completes the word before the cursor
+* The first word on the line is completed as a command, from the command trie,
+* unless it contains a '/'. Other words are completed as file paths.
+* Completes as much as all of the matches have in common, and lists the matches
+* if tab is pressed again when there's nothing more to complete
+*/
+static void completeWord(struct LineEditor* editor) {
+    int wordStart = editor->cursor;
+    struct TrieNode* trie;
+    char* prefix;
+    char* slash;
+    char* directoryPath = NULL;
+
+    while (wordStart > 0 && editor->buffer[wordStart - 1] != ' ') {
+        --wordStart;
+    }
+
+    char* word = strndup(&editor->buffer[wordStart], editor->cursor - wordStart);
+    bool isCommand = strspn(editor->buffer, " ") == (size_t) wordStart && !strchr(word, '/');
+
+    if (isCommand) {
+        refreshCommandTrie();
+        trie = &GLOBAL_commandTrie;
+        prefix = word;
+    } else {
+        // complete the part after the last '/' from a listing of the part before it
+        slash = strrchr(word, '/');
+        if (slash) {
+            directoryPath = strndup(word, slash - word + 1);
+            prefix = slash + 1;
+        } else {
+            directoryPath = strdup(".");
+            prefix = word;
+        }
+        trie = getDirectoryListing(directoryPath);
+    }
+
+    struct TrieNode* node = trie ? findTrieNode(trie, prefix) : NULL;
+
+    if (!node || node->wordCount == 0) {
+        write(STDOUT_FILENO, "\a", 1);  // beep, nothing matches
+    } else {
+        // follow the trie while there's only one way to go
+        char completion[MAX_INPUT_LENGTH + 1];
+        int completionLength = 0;
+        while (node->refCount == 0 && completionLength < MAX_INPUT_LENGTH) {
+            struct TrieNode* onlyChild = NULL;
+            int liveChildren = 0;
+
+            for (struct TrieNode* child = node->firstChild; child; child = child->nextSibling) {
+                if (child->wordCount > 0) {
+                    onlyChild = child;
+                    ++liveChildren;
+                }
+            }
+
+            if (liveChildren != 1) {
+                break;
+            }
+
+            node = onlyChild;
+            completion[completionLength++] = node->character;
+        }
+
+        insertEditorText(editor, completion, completionLength);
+
+        if (node->wordCount == 1) {
+            // a unique match is complete, so start the next word (unless it's a directory)
+            if (completionLength == 0 || completion[completionLength - 1] != '/') {
+                insertEditorText(editor, " ", 1);
+            }
+        } else if (completionLength == 0 && editor->wasTab) {
+            // nothing more to complete, so list the choices
+            char* fullPrefix = strndup(&editor->buffer[editor->cursor - strlen(prefix)], strlen(prefix));
+            printTrieWords(node, fullPrefix);
+            free(fullPrefix);
+        } else if (completionLength == 0) {
+            write(STDOUT_FILENO, "\a", 1);  // beep, press tab again for the list
+        }
+    }
+
+    free(word);
+    free(directoryPath);
+
+    return;
+}
+
+
+/*
+* Moves through the history while editing a line
+* direction: -1 for older entries, 1 for newer entries
+*/
+static void browseHistory(struct LineEditor* editor, int direction) {
+    int entryIndex = editor->historyIndex;
+
+    indexHistory();
+
+    // skip over duplicates that were superseded by later entries
+    do {
+        entryIndex += direction;
+    } while (entryIndex >= 0 && entryIndex < GLOBAL_history.entryCount && GLOBAL_history.entries[entryIndex].isSuperseded);
+
+    if (entryIndex < 0 || entryIndex > GLOBAL_history.entryCount) {
+        write(STDOUT_FILENO, "\a", 1);  // beep, no more history that way
+        return;
+    }
+
+    // save the line being edited before showing history
+    if (editor->historyIndex == GLOBAL_history.entryCount) {
+        free(editor->savedLine);
+        editor->savedLine = strndup(editor->buffer, editor->length);
+    }
+
+    editor->historyIndex = entryIndex;
+
+    if (entryIndex == GLOBAL_history.entryCount) {
+        // back past the newest entry, to the line that was being edited
+        setEditorText(editor, editor->savedLine, strlen(editor->savedLine));
+    } else {
+        struct HistoryEntry* entry = &GLOBAL_history.entries[entryIndex];
+        setEditorText(editor, entry->text, entry->length);
+    }
+
+    return;
+}
+
+
+/*
+* Searches back through the history as the user types (ctrl+R), using the prefix index
+* Typing extends the search, ctrl+R finds the next older match, ctrl+G cancels,
+* enter runs the match, and any other key stops searching with the match on the line
+* return: the key that ended the search
+*/
+static int searchHistory(struct LineEditor* editor) {
+    char query[MAX_INPUT_LENGTH + 1] = {0};
+    int queryLength = 0;
+    int matchIndex = -1;
+    char label[MAX_INPUT_LENGTH + 32];
+    char* originalLine = strndup(editor->buffer, editor->length);
+    int key;
+
+    indexHistory();
+
+    while (true) {
+        sprintf(label, "(reverse-i-search)`%s': ", query);
+        refreshLine(editor, label);
+
+        key = readKey();
+
+        if (key == KEY_TIMER) {
+            // scheduled commands ran; just redraw the search
+            continue;
+        } else if (key == 18) {
+            // ctrl+R: next older match
+            int olderIndex = findHistoryByPrefix(query, matchIndex == -1 ? GLOBAL_history.entryCount : matchIndex);
+            if (olderIndex == -1) {
+                write(STDOUT_FILENO, "\a", 1);
+                continue;
+            }
+            matchIndex = olderIndex;
+        } else if ((key == 127 || key == 8) && queryLength > 0) {
+            // backspace: shorten the search
+            query[--queryLength] = '\0';
+            matchIndex = findHistoryByPrefix(query, GLOBAL_history.entryCount);
+        } else if (key >= 32 && key < 127 && queryLength < MAX_INPUT_LENGTH) {
+            // extend the search
+            query[queryLength++] = key;
+            query[queryLength] = '\0';
+
+            int newIndex = findHistoryByPrefix(query, GLOBAL_history.entryCount);
+            if (newIndex == -1) {
+                write(STDOUT_FILENO, "\a", 1);
+                query[--queryLength] = '\0';
+                continue;
+            }
+            matchIndex = newIndex;
+        } else if (key == 7) {
+            // ctrl+G: cancel, restoring the original line
+            setEditorText(editor, originalLine, strlen(originalLine));
+            break;
+        } else {
+            break;
+        }
+
+        if (matchIndex != -1) {
+            struct HistoryEntry* entry = &GLOBAL_history.entries[matchIndex];
+            setEditorText(editor, entry->text, entry->length);
+        }
+    }
+
+    free(originalLine);
+
+    return key;
+}
+
+
+/*
+* Reads a line from the terminal with editing, history, and tab completion
+* Keys: left/right, home/end (ctrl+A/ctrl+E), backspace, delete, ctrl+U, ctrl+K, ctrl+W,
+* up/down (ctrl+P/ctrl+N) for history, ctrl+R to search history, and tab to complete.
+* If a signal (like SIGINT or SIGTSTP) interrupts reading, the line is abandoned and an
+* empty line is returned, the same way an interrupted fgets() behaves.
+* prompt: the prompt, which must already be printed; it's redrawn with the line
+* return: the line (without a newline), or NULL at end of input
+*/
+char* readEditedLine(const char* prompt) {
+    struct termios originalSettings;
+    struct LineEditor* editor = calloc(1, sizeof(struct LineEditor));
+    char* line = NULL;
+    bool isDone = false;
+
+    editor->prompt = prompt;
+
+    editor->historyIndex = GLOBAL_history.isIndexed ? GLOBAL_history.entryCount : -1;
+
+    // without raw mode there's no editing, but the terminal still gives whole lines
+    if (!enableRawMode(&originalSettings)) {
+        size_t capacity = 0;
+
+        free(editor);
+        errno = 0;
+
+        if (getInputLine(&line, &capacity) == -1) {
+            // an interrupted read abandons the line, like the editor does
+            if (errno == EINTR) {
+                line = realloc(line, 1);
+                line[0] = '\0';
+                return line;
+            }
+
+            free(line);
+            return NULL;
+        }
+
+        line[strcspn(line, "\n")] = '\0';
+
+        if (strlen(line) > MAX_INPUT_LENGTH) {
+            line[MAX_INPUT_LENGTH] = '\0';
+        }
+
+        return line;
+    }
+
+    while (!isDone) {
+        int key = readKey();
+        bool isTab = false;
+
+        // history is indexed lazily, so work out where browsing starts when it's needed
+        if ((key == KEY_ARROW_UP || key == KEY_ARROW_DOWN || key == 16 || key == 14) && editor->historyIndex == -1) {
+            indexHistory();
+            editor->historyIndex = GLOBAL_history.entryCount;
+        }
+
+        // ctrl+R might end on a key that should still be handled
+        if (key == 18) {
+            key = searchHistory(editor);
+
+            if (key == 18 || key == 7) {
+                refreshLine(editor, NULL);
+                continue;
+            }
+        }
+
+        switch (key) {
+            case KEY_INTERRUPTED:
+                // abandon the line, returning it as empty input
+                write(STDOUT_FILENO, "\n", 1);
+                line = calloc(1, sizeof(char));
+                isDone = true;
+                continue;
+
+            case KEY_END_OF_FILE:
+                isDone = true;
+                continue;
+
+            case KEY_TIMER:
+                // redraw the line below anything scheduled commands printed
+                isTab = editor->wasTab;
+                break;
+
+            case '\r':
+            case '\n':
+                write(STDOUT_FILENO, "\n", 1);
+                line = strndup(editor->buffer, editor->length);
+                isDone = true;
+                continue;
+
+            case 4:  // ctrl+D: end of input on an empty line, otherwise delete
+                if (editor->length == 0) {
+                    isDone = true;
+                    continue;
+                }
+                deleteEditorText(editor, editor->cursor, editor->cursor + 1);
+                break;
+
+            case KEY_DELETE:
+                deleteEditorText(editor, editor->cursor, editor->cursor + 1);
+                break;
+
+            case 127:  // backspace
+            case 8:  // ctrl+H
+                deleteEditorText(editor, editor->cursor - 1, editor->cursor);
+                break;
+
+            case KEY_ARROW_LEFT:
+            case 2:  // ctrl+B
+                editor->cursor -= editor->cursor > 0;
+                break;
+
+            case KEY_ARROW_RIGHT:
+            case 6:  // ctrl+F
+                editor->cursor += editor->cursor < editor->length;
+                break;
+
+            case KEY_HOME:
+            case 1:  // ctrl+A
+                editor->cursor = 0;
+                break;
+
+            case KEY_END:
+            case 5:  // ctrl+E
+                editor->cursor = editor->length;
+                break;
+
+            case 21:  // ctrl+U: delete to the start of the line
+                deleteEditorText(editor, 0, editor->cursor);
+                break;
+
+            case 11:  // ctrl+K: delete to the end of the line
+                deleteEditorText(editor, editor->cursor, editor->length);
+                break;
+
+            case 23: {  // ctrl+W: delete the word before the cursor
+                int wordStart = editor->cursor;
+                while (wordStart > 0 && editor->buffer[wordStart - 1] == ' ') {
+                    --wordStart;
+                }
+                while (wordStart > 0 && editor->buffer[wordStart - 1] != ' ') {
+                    --wordStart;
+                }
+                deleteEditorText(editor, wordStart, editor->cursor);
+                break;
+            }
+
+            case KEY_ARROW_UP:
+            case 16:  // ctrl+P
+                browseHistory(editor, -1);
+                break;
+
+            case KEY_ARROW_DOWN:
+            case 14:  // ctrl+N
+                browseHistory(editor, 1);
+                break;
+
+            case '\t':
+                completeWord(editor);
+                isTab = true;
+                break;
+
+            default:
+                // insert printable chars; ignore other control keys
+                if (key >= 32 && key < 256 && key != 127) {
+                    char character = key;
+                    insertEditorText(editor, &character, 1);
+                }
+                break;
+        }
+
+        editor->wasTab = isTab;
+        refreshLine(editor, NULL);
+    }
+
+    disableRawMode(&originalSettings);
+
+    free(editor->savedLine);
+    free(editor);
+
+    return line;
+}
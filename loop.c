@@ -0,0 +1,427 @@
+// repeat and for loops, which parse their body once and run it many times
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* A string in a parsed loop body that uses the loop variable
+* The text around each use of the variable is split into pieces when the body is
+* parsed, so each iteration only has to join the pieces with the variable's value
+*/
+struct LoopField {
+    char** target;  // where the string is in the body's CommandLine
+    char* original;  // the string as parsed, put back before the CommandLine is freed
+    char** pieces;  // text between uses of the variable (one more piece than uses)
+    size_t* pieceLengths;
+    int pieceCount;
+};
+
+
+/*
+* One command of a loop body, parsed once
+*/
+struct LoopCommand {
+    struct CommandLine* commandLine;
+    struct LoopField* fields;
+    int fieldCount;
+};
+
+
+/*
+* Finds the next use of a variable in a string, as $NAME or ${NAME}
+* text: string to search
+* variableName: the variable's name
+* useLength: set to the length of the use that was found
+* return: pointer to the use's $, or NULL if there are no more uses
+*/
+static char* findVariableUse(char* text, const char* variableName, size_t* useLength) {
+    size_t nameLength = strlen(variableName);
+
+    for (char* dollar = strchr(text, '$'); dollar; dollar = strchr(dollar + 1, '$')) {
+        if (strncmp(dollar + 1, variableName, nameLength) == 0) {
+            // $NAME must not run into more name characters, like $NAMES
+            char nextChar = dollar[1 + nameLength];
+
+            if (nextChar != '_' && !isalnum((unsigned char) nextChar)) {
+                *useLength = 1 + nameLength;
+                return dollar;
+            }
+        } else if (dollar[1] == '{' && strncmp(dollar + 2, variableName, nameLength) == 0
+                   && dollar[2 + nameLength] == '}') {
+            *useLength = 3 + nameLength;
+            return dollar;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+* Notes a string in a loop body's CommandLine if it uses the loop variable,
+* splitting it into the pieces around each use
+* loopCommand: the body command the string is in
+* target: where the string is in the CommandLine
+* variableName: the loop variable's name
+*/
+static void addLoopField(struct LoopCommand* loopCommand, char** target, const char* variableName) {
+    size_t useLength;
+    char* text = *target;
+
+    // strings that don't use the variable are the same every iteration
+    if (!text || !findVariableUse(text, variableName, &useLength)) {
+        return;
+    }
+
+    loopCommand->fields = realloc(loopCommand->fields, (loopCommand->fieldCount + 1) * sizeof(struct LoopField));
+    struct LoopField* field = &loopCommand->fields[loopCommand->fieldCount];
+    ++loopCommand->fieldCount;
+
+    field->target = target;
+    field->original = text;
+    field->pieces = NULL;
+    field->pieceLengths = NULL;
+    field->pieceCount = 0;
+
+    // split the string at each use, keeping one more piece than there are uses
+    while (true) {
+        char* use = findVariableUse(text, variableName, &useLength);
+        size_t pieceLength = use ? (size_t) (use - text) : strlen(text);
+
+        field->pieces = realloc(field->pieces, (field->pieceCount + 1) * sizeof(char*));
+        field->pieceLengths = realloc(field->pieceLengths, (field->pieceCount + 1) * sizeof(size_t));
+        field->pieces[field->pieceCount] = text;
+        field->pieceLengths[field->pieceCount] = pieceLength;
+        ++field->pieceCount;
+
+        if (!use) {
+            break;
+        }
+
+        text = use + useLength;
+    }
+
+    return;
+}
+
+
+/*
+* Parses one command of a loop body, and notes which of its strings use the loop variable
+* loopCommand: filled with the parsed command
+* commandString: the command's text (consumed by the parser)
+* variableName: the loop variable's name, or NULL if the loop has none
+*/
+static void parseLoopCommand(struct LoopCommand* loopCommand, char* commandString, const char* variableName) {
+    struct CommandLine* commandLine = parseCommandString(commandString);
+
+    // a here-document's text comes from the lines after the loop, and is read only once
+    if (commandLine->hereDocDelimiter) {
+        readHereDocument(commandLine);
+    }
+
+    loopCommand->commandLine = commandLine;
+    loopCommand->fields = NULL;
+    loopCommand->fieldCount = 0;
+
+    if (!variableName) {
+        return;
+    }
+
+    // note every string that could use the variable
+    addLoopField(loopCommand, &commandLine->command, variableName);
+
+    for (int index = 0; index < commandLine->argCount; ++index) {
+        addLoopField(loopCommand, &commandLine->args[index], variableName);
+    }
+
+    addLoopField(loopCommand, &commandLine->inFile, variableName);
+    addLoopField(loopCommand, &commandLine->outFile, variableName);
+    addLoopField(loopCommand, &commandLine->errFile, variableName);
+
+    for (int index = 0; index < commandLine->teeFileCount; ++index) {
+        addLoopField(loopCommand, &commandLine->teeFiles[index], variableName);
+    }
+
+    return;
+}
+
+
+/*
+* Runs a loop body once, with the loop variable set to a value
+* commands: the parsed body
+* commandCount: number of commands in the body
+* value: the loop variable's value (ignored if the loop has no variable)
+*/
+static void runLoopBody(struct LoopCommand* commands, int commandCount, const char* value) {
+    size_t valueLength = value ? strlen(value) : 0;
+
+    for (int commandIndex = 0; commandIndex < commandCount && !GLOBAL_receivedSIGINT; ++commandIndex) {
+        struct LoopCommand* loopCommand = &commands[commandIndex];
+
+        // expand the variable by joining each string's pieces with the value
+        for (int fieldIndex = 0; fieldIndex < loopCommand->fieldCount; ++fieldIndex) {
+            struct LoopField* field = &loopCommand->fields[fieldIndex];
+            size_t expandedLength = (field->pieceCount - 1) * valueLength;
+
+            for (int piece = 0; piece < field->pieceCount; ++piece) {
+                expandedLength += field->pieceLengths[piece];
+            }
+
+            char* expanded = malloc(expandedLength + 1);
+            char* end = expanded;
+
+            for (int piece = 0; piece < field->pieceCount; ++piece) {
+                if (piece > 0) {
+                    memcpy(end, value, valueLength);
+                    end += valueLength;
+                }
+
+                memcpy(end, field->pieces[piece], field->pieceLengths[piece]);
+                end += field->pieceLengths[piece];
+            }
+
+            *end = '\0';
+            *field->target = expanded;
+        }
+
+        if (loopCommand->commandLine->command) {
+            executeCommand(loopCommand->commandLine);
+        }
+
+        // put the parsed strings back for the next iteration
+        for (int fieldIndex = 0; fieldIndex < loopCommand->fieldCount; ++fieldIndex) {
+            free(*loopCommand->fields[fieldIndex].target);
+            *loopCommand->fields[fieldIndex].target = loopCommand->fields[fieldIndex].original;
+        }
+    }
+
+    // clean up zombies, so background commands in the body don't fill the job table,
+    // and run any scheduled commands that came due, so they don't wait for the loop
+    reapAll();
+    runDueTimers();
+
+    return;
+}
+
+
+/*
+* Frees a parsed loop body
+* commands: the parsed body
+* commandCount: number of commands in the body
+*/
+static void freeLoopCommands(struct LoopCommand* commands, int commandCount) {
+    for (int commandIndex = 0; commandIndex < commandCount; ++commandIndex) {
+        for (int fieldIndex = 0; fieldIndex < commands[commandIndex].fieldCount; ++fieldIndex) {
+            free(commands[commandIndex].fields[fieldIndex].pieces);
+            free(commands[commandIndex].fields[fieldIndex].pieceLengths);
+        }
+
+        free(commands[commandIndex].fields);
+        freeCommandLine(commands[commandIndex].commandLine);
+    }
+
+    free(commands);
+
+    return;
+}
+
+
+/*
+* Joins tokens back into a command string, with a space between each
+* tokens: the tokens
+* tokenCount: number of tokens
+* return: the command string
+*/
+static char* joinTokens(char** tokens, int tokenCount) {
+    size_t length = 1;
+
+    for (int index = 0; index < tokenCount; ++index) {
+        length += strlen(tokens[index]) + 1;
+    }
+
+    char* joined = calloc(length, sizeof(char));
+
+    for (int index = 0; index < tokenCount; ++index) {
+        if (index > 0) {
+            strcat(joined, " ");
+        }
+
+        strcat(joined, tokens[index]);
+    }
+
+    return joined;
+}
+
+
+/*
+* Checks whether a string is a valid variable name (letters, digits, and _, not
+* starting with a digit)
+* name: string to check
+* return: true if it's a valid name
+*/
+static bool isVariableName(const char* name) {
+    if (!isalpha((unsigned char) name[0]) && name[0] != '_') {
+        return false;
+    }
+
+    for (const char* nameChar = name; *nameChar; ++nameChar) {
+        if (!isalnum((unsigned char) *nameChar) && *nameChar != '_') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+* Runs repeat N command [arg...]
+* tokens: the loop's tokens, starting with "repeat"
+* tokenCount: number of tokens
+*/
+static void runRepeatLoop(char** tokens, int tokenCount) {
+    char* end;
+    long count = tokenCount >= 3 ? strtol(tokens[1], &end, 10) : -1;
+
+    if (count < 0 || *end != '\0') {
+        printToTerminal("usage: repeat N command [arg...]\n", false);
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    // parse the command once
+    struct LoopCommand* command = calloc(1, sizeof(struct LoopCommand));
+    char* commandString = joinTokens(tokens + 2, tokenCount - 2);
+    parseLoopCommand(command, commandString, NULL);
+    free(commandString);
+
+    // ctrl+C stops the loop
+    GLOBAL_receivedSIGINT = 0;
+
+    for (long iteration = 0; iteration < count && !GLOBAL_receivedSIGINT; ++iteration) {
+        runLoopBody(command, 1, NULL);
+    }
+
+    freeLoopCommands(command, 1);
+
+    return;
+}
+
+
+/*
+* Runs for VAR in LIST; do command; [command;] done
+* The commands in the body are separated by ; (as a token, or at the end of one)
+* tokens: the loop's tokens, starting with "for"
+* tokenCount: number of tokens
+*/
+static void runForLoop(char** tokens, int tokenCount) {
+    char* variableName = tokenCount >= 2 ? tokens[1] : "";
+    int tokenIndex = 3;
+    int valuesStart = 3;
+    int valueCount = 0;
+    struct LoopCommand* commands = NULL;
+    int commandCount = 0;
+
+    // the list ends at a ; token, or a token ending with ;
+    while (tokenIndex < tokenCount && tokens[tokenIndex][strlen(tokens[tokenIndex]) - 1] != ';') {
+        ++tokenIndex;
+    }
+
+    if (tokenIndex < tokenCount) {
+        // a ; at the end of a value isn't part of it
+        tokens[tokenIndex][strlen(tokens[tokenIndex]) - 1] = '\0';
+        valueCount = tokenIndex - valuesStart + (tokens[tokenIndex][0] != '\0' ? 1 : 0);
+        ++tokenIndex;
+    }
+
+    // check the syntax around the list and body
+    if (tokenCount < 4 || !isVariableName(variableName) || !isEqualString(tokens[2], "in")
+            || tokenIndex >= tokenCount || !isEqualString(tokens[tokenIndex], "do")
+            || !isEqualString(tokens[tokenCount - 1], "done")) {
+        printToTerminal("usage: for VAR in LIST; do command; [command;] done\n", false);
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    // parse each command of the body once
+    ++tokenIndex;
+
+    while (tokenIndex < tokenCount - 1) {
+        int commandStart = tokenIndex;
+        int commandLength;
+
+        // the command ends at a ; token, or a token ending with ;
+        while (tokenIndex < tokenCount - 1 && tokens[tokenIndex][strlen(tokens[tokenIndex]) - 1] != ';') {
+            ++tokenIndex;
+        }
+
+        commandLength = tokenIndex - commandStart;
+
+        if (tokenIndex < tokenCount - 1) {
+            tokens[tokenIndex][strlen(tokens[tokenIndex]) - 1] = '\0';
+            commandLength += tokens[tokenIndex][0] != '\0' ? 1 : 0;
+            ++tokenIndex;
+        }
+
+        if (commandLength > 0) {
+            commands = realloc(commands, (commandCount + 1) * sizeof(struct LoopCommand));
+            char* commandString = joinTokens(tokens + commandStart, commandLength);
+            parseLoopCommand(&commands[commandCount], commandString, variableName);
+            free(commandString);
+            ++commandCount;
+        }
+    }
+
+    // ctrl+C stops the loop
+    GLOBAL_receivedSIGINT = 0;
+
+    for (int valueIndex = 0; valueIndex < valueCount && !GLOBAL_receivedSIGINT; ++valueIndex) {
+        runLoopBody(commands, commandCount, tokens[valuesStart + valueIndex]);
+    }
+
+    freeLoopCommands(commands, commandCount);
+
+    return;
+}
+
+
+/*
+* Runs a command string if it's a loop:
+*   repeat N command [arg...]
+*   for VAR in LIST; do command; [command;] done
+* The loop's body is parsed once, and then each iteration only expands $VAR (or ${VAR})
+* and runs the parsed commands, so running a command many times costs no more parsing
+* than running it once. Ctrl+C stops a loop
+* commandString: a line of input, already expanded by expandPidVariable()
+* return: true if it was a loop (which has now run); false if it should be run normally
+*/
+bool runLoopCommand(char* commandString) {
+    char* tokens[MAX_ARG_COUNT] = {NULL};
+    int tokenCount = 0;
+    char* indexPointer;
+    char* commandStart = commandString + strspn(commandString, " ");
+
+    // most lines aren't loops, so check that before copying anything
+    if (strncmp(commandStart, "repeat ", 7) != 0 && strncmp(commandStart, "for ", 4) != 0) {
+        return false;
+    }
+
+    // split the loop into tokens
+    char* stringCopy = strdup(commandString);
+
+    for (char* token = strtok_r(stringCopy, " ", &indexPointer); token && tokenCount < MAX_ARG_COUNT;
+         token = strtok_r(NULL, " ", &indexPointer)) {
+        tokens[tokenCount] = token;
+        ++tokenCount;
+    }
+
+    if (isEqualString(tokens[0], "repeat")) {
+        runRepeatLoop(tokens, tokenCount);
+    } else {
+        runForLoop(tokens, tokenCount);
+    }
+
+    free(stringCopy);
+
+    return true;
+}
@@ -7,25 +7,43 @@
 
 /*
 *   Runs an interactive shell program
-*   Compile the program as follows:
-*       gcc --std=gnu99 -o smallsh main.c
+*   Compile the program (and the libsmallsh core it links) as follows:
+*       make
 */
 int main(int argc, char* argv[]) {
     setSIGINThandler();
     setSIGTSTPhandler(false);  // child processes override this when created
+    loadHistory();
+    startWarmUp();  // only if $SMALLSH_PREFETCH is set
+    startEventLog();
 
     while (true) {
         printCommandPrompt();
 
-        struct CommandLine* commandLine = parseCommandString(getUserCommandString());
+        char* commandString = getUserCommandString();
 
-        // handle empty input (also caused by signals interrupting fgets)
-        if (commandLine->command) {
-            executeCommand(commandLine);
+        // repeat and for loops parse and run their own body
+        if (!runLoopCommand(commandString)) {
+            struct CommandLine* commandLine = parseCommandString(commandString);
+
+            // a here-document's text comes from the lines after the command
+            if (commandLine->hereDocDelimiter) {
+                readHereDocument(commandLine);
+            }
+
+            // handle empty input (also caused by signals interrupting fgets)
+            if (commandLine->command) {
+                executeCommand(commandLine);
+            }
+
+            freeCommandLine(commandLine);
         }
 
-        // clean up zombies
+        free(commandString);
+
+        // clean up zombies, and run any scheduled commands that came due during the command
         reapAll();
+        runDueTimers();
     }
 
     // enter or exit foreground only mode
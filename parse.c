@@ -0,0 +1,315 @@
+// Parsing command lines into CommandLine structs
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* Wrapper for strcmp
+* string1: any string
+* string2: any string
+* return: true if string1 is equal to string2; false if not
+*/
+bool isEqualString(char* string1, char* string2) {
+    return strcmp(string1, string2) == 0;
+}
+
+
+/*
+* Wrapper for strncmp
+* prefix: any string that will be checked to be a substring of string,
+*         checking LTR up to the length of string
+* string: any string that will be checked to contain prefix
+* return: true if prefix is a substring of string; false if not
+*/
+static bool isPrefix(char* prefix, char* string) {
+    return strncmp(prefix, string, strlen(prefix)) == 0;
+}
+
+
+/*
+* counts the number of spaces in a string
+* return: the number of spaces in the given string
+*/
+static int countSpaces(char* stringIn) {
+    int spacesCount = 0;
+    char* charCheckPointer = stringIn;
+
+    // search for spaces in the string
+    while (*charCheckPointer != '\0') {
+        if (*charCheckPointer == ' ') {
+            // found a space
+            ++spacesCount;
+        }
+
+        // advance pointer
+        ++charCheckPointer;
+    }
+
+    return spacesCount;
+}
+
+
+/*
+* Sets a command line's here-string, which is given to the command as stdin with a newline
+* commandLine: pointer to a CommandLine struct
+* word: the here-string
+*/
+static void setHereString(struct CommandLine* commandLine, char* word) {
+    commandLine->hereDocumentLength = strlen(word) + 1;
+    commandLine->hereDocument = calloc(commandLine->hereDocumentLength + 1, sizeof(char));
+    strcpy(commandLine->hereDocument, word);
+    strcat(commandLine->hereDocument, "\n");
+
+    return;
+}
+
+
+/*
+* reads a line from the prompt and saves parsed input to the given struct
+* does not check for syntax errors (per specs)
+* does not support quoting, so arguments with spaces are not possible (per specs)
+* command syntax is
+*       command [arg1 arg2 ...] [< input_file] [> output_file] [2> error_file] [&]
+*   where square-bracketed items are optional. Note that special characters
+*   must still be surrounded by spaces. 
+*   The < redirects input and the > redirects output.
+*   Also supported are >> (append output), 2> and 2>> (errors), 2>&1 (errors
+*   go wherever output goes), &> and &>> (output and errors), <> (input
+*   opened for reading and writing), <<< word (a here-string, which can also be
+*   written <<<word), and << DELIMITER (a here-document, read later by
+*   readHereDocument(), which can also be written <<DELIMITER).
+*   Redirections can appear in any order.
+*   The & is only special as the last character,
+*   where it means "run command in the background"
+*   Any instance of $$ is expanded into the smallsh process id
+* inputString: one line of unprocessed user input
+* return: pointer to a CommandLine struct where parsed results will be saved
+*/
+struct CommandLine* parseCommandString(char* stringInput) {
+    char* indexPointer;
+    char* inputToken;
+    char* delimiter = " ";
+    char inputRedirectChar = '<';
+    char outputRedirectChar = '>';
+    char backgroundChar = '&';
+    bool isInFileName = false;
+    bool isOutFileName = false;
+    bool isErrFileName = false;
+    bool isTeeFileName = false;
+    bool isHereString = false;
+    bool isHereDocDelimiter = false;
+    bool argsAreDone = false;
+    bool isSpecialChar = false;
+    struct CommandLine* commandLine = malloc(sizeof(struct CommandLine));
+    int tokenCount = 0;
+    int tokenIndex = 0;
+    char* stringInputCopy = calloc(strlen(stringInput) + 1, sizeof(char));
+    strcpy(stringInputCopy, stringInput);  // enables using the stringInput string alongside strtok_r()
+
+    // initialize the CommandLine struct's fixed-size array to all null pointers
+    // and initialize its other defaults
+    commandLine->args = calloc(MAX_ARG_COUNT, sizeof(char*));
+    commandLine->argCount = 0;
+    commandLine->isBackground = false;
+    commandLine->command = NULL;
+    commandLine->inFile = NULL;
+    commandLine->outFile = NULL;
+    commandLine->errFile = NULL;
+    commandLine->isInFileWritable = false;
+    commandLine->isOutAppend = false;
+    commandLine->isErrAppend = false;
+    commandLine->isErrToOut = false;
+    commandLine->hereDocDelimiter = NULL;
+    commandLine->hereDocument = NULL;
+    commandLine->hereDocumentLength = 0;
+    commandLine->teeFiles = NULL;
+    commandLine->teeFileCount = 0;
+
+    // Process first token now, because it's unique.
+    // It is the first that shows whether input is empty, and
+    // it is the only non-optional token
+    inputToken = strtok_r(stringInput, delimiter, &indexPointer);
+
+    if (inputToken != NULL) {
+        commandLine->command = calloc(strlen(inputToken) + 1, sizeof(char));
+        strcpy(commandLine->command, inputToken);
+    }
+
+    // count the number of tokens to be extracted
+    // (the special char "&" is only heeded if in the last token)
+    if (inputToken != NULL) {
+        tokenCount = countSpaces(stringInputCopy);
+
+        // account for the first token before a space
+        ++tokenCount;
+
+        // track how many tokens have been parsed
+        ++tokenIndex;
+    }
+
+    // try to extract another token in case there are args or options
+    inputToken = strtok_r(NULL, delimiter, &indexPointer);
+
+    // handle remaining tokens in the command string
+    while (inputToken != NULL) {
+        // track how many tokens have been parsed
+        ++tokenIndex;
+
+        // determine the char at the last index of this token
+        char* lastCharPointer = stringInputCopy;
+        char lastTokenChar = '\0';
+        while (*lastCharPointer != '\0') {
+            lastTokenChar = *lastCharPointer;
+            ++lastCharPointer;
+        }
+
+        // parsing logic:
+        // if it's token #1, it's a command (already processed)
+        // if it's after token #1 and no flag set for "passed a special char", it's an arg
+        // if it's a < > special char, flag it
+        // if it's after a special char, it's that char's thing; cancel flag
+        // if it's the & and the last token, run in background is true
+
+        // check first character of this token to see if it's a special character
+        // if it is a special character, take note that we have passed the args section
+        isSpecialChar = false;
+        if (isPrefix("<<<", inputToken)) {
+            // the here-string is the rest of this token, or the next token
+            if (inputToken[3] != '\0') {
+                setHereString(commandLine, inputToken + 3);
+            } else {
+                isHereString = true;
+            }
+            isSpecialChar = true;
+        } else if (isPrefix("<<", inputToken)) {
+            // the here-document's delimiter is the rest of this token, or the next token
+            if (inputToken[2] != '\0') {
+                commandLine->hereDocDelimiter = strdup(inputToken + 2);
+            } else {
+                isHereDocDelimiter = true;
+            }
+            isSpecialChar = true;
+        } else if (isEqualString(inputToken, "2>") || isEqualString(inputToken, "2>>")) {
+            // next token will be error file name
+            isErrFileName = true;
+            isSpecialChar = true;
+            commandLine->isErrAppend = inputToken[2] == outputRedirectChar;
+        } else if (isEqualString(inputToken, "2>&1")) {
+            // errors go wherever output goes
+            commandLine->isErrToOut = true;
+            isSpecialChar = true;
+        } else if (isEqualString(inputToken, "&>") || isEqualString(inputToken, "&>>")) {
+            // next token will be the file name for both output and errors
+            isOutFileName = true;
+            isSpecialChar = true;
+            commandLine->isOutAppend = inputToken[2] == outputRedirectChar;
+            commandLine->isErrToOut = true;
+        } else if (isEqualString(inputToken, ">+")) {
+            // next token will be a file that gets a copy of the output
+            isTeeFileName = true;
+            isSpecialChar = true;
+        } else if (inputToken[0] == inputRedirectChar) {
+            // next token will be input file name (<> opens it for writing too)
+            isInFileName = true;
+            isSpecialChar = true;
+            commandLine->isInFileWritable = inputToken[1] == outputRedirectChar;
+        } else if (inputToken[0] == outputRedirectChar) {
+            // next token will be output file name (>> appends to it)
+            isOutFileName = true;
+            isSpecialChar = true;
+            commandLine->isOutAppend = inputToken[1] == outputRedirectChar;
+        } else if (lastTokenChar == backgroundChar && tokenIndex == tokenCount) {
+            // handle isBackground preference
+            commandLine->isBackground = true;
+            isSpecialChar = true;
+        }
+
+        // syntax rules say args come before all special characters,
+        // so if we reach a special character, we know args are done
+        if (isSpecialChar == true) {
+            argsAreDone = true;
+        }
+
+        // check flags that depend on special characters
+        if (isHereString && !isSpecialChar) {
+            // this is the text of the here-string. Save it
+            setHereString(commandLine, inputToken);
+            isHereString = false;
+        } else if (isHereDocDelimiter && !isSpecialChar) {
+            // this is the delimiter of the here-document. Save it; the text is read later
+            commandLine->hereDocDelimiter = strdup(inputToken);
+            isHereDocDelimiter = false;
+        } else if (isInFileName && !isSpecialChar) {
+            // this is the name of the input file. Save it
+            commandLine->inFile = calloc(strlen(inputToken) + 1, sizeof(char));
+            strcpy(commandLine->inFile, inputToken);
+
+            // make sure the next token isn't treated as the input file name!
+            isInFileName = false;
+        } else if (isOutFileName && !isSpecialChar) {
+            // this is the name of the output file. Save it
+            commandLine->outFile = calloc(strlen(inputToken) + 1, sizeof(char));
+            strcpy(commandLine->outFile, inputToken);
+
+            // make sure the next token isn't treated as the output file name!
+            isOutFileName = false;
+        } else if (isErrFileName && !isSpecialChar) {
+            // this is the name of the error file. Save it
+            commandLine->errFile = calloc(strlen(inputToken) + 1, sizeof(char));
+            strcpy(commandLine->errFile, inputToken);
+
+            // make sure the next token isn't treated as the error file name!
+            isErrFileName = false;
+        } else if (isTeeFileName && !isSpecialChar) {
+            // this is the name of a file to copy the output to. Add it to the list
+            commandLine->teeFiles = realloc(commandLine->teeFiles, (commandLine->teeFileCount + 1) * sizeof(char*));
+            commandLine->teeFiles[commandLine->teeFileCount] = strdup(inputToken);
+            ++commandLine->teeFileCount;
+
+            isTeeFileName = false;
+        } else if (!argsAreDone) {
+            // this token is an arg. Add it to the array of args 
+            // and increment the arg count so the next arg is added at the end
+            commandLine->args[commandLine->argCount] = calloc(strlen(inputToken) + 1, sizeof(char));
+            strcpy(commandLine->args[commandLine->argCount], inputToken);
+
+            ++commandLine->argCount;
+        }
+
+        // try to extract another token in case there are more
+        inputToken = strtok_r(NULL, delimiter, &indexPointer);
+    }
+
+    free(stringInputCopy);
+    
+    // return a pointer to the struct which now has all the parsed data in it
+    return commandLine;
+}
+
+
+/*
+* Frees a CommandLine struct made by parseCommandString() and everything it holds
+* commandLine: pointer to the CommandLine struct to free
+*/
+void freeCommandLine(struct CommandLine* commandLine) {
+    for (int index = 0; index < commandLine->argCount; ++index) {
+        free(commandLine->args[index]);
+    }
+
+    free(commandLine->args);
+    free(commandLine->command);
+    free(commandLine->inFile);
+    free(commandLine->outFile);
+    free(commandLine->errFile);
+    free(commandLine->hereDocDelimiter);
+    free(commandLine->hereDocument);
+
+    for (int index = 0; index < commandLine->teeFileCount; ++index) {
+        free(commandLine->teeFiles[index]);
+    }
+
+    free(commandLine->teeFiles);
+    free(commandLine);
+
+    return;
+}
@@ -0,0 +1,742 @@
+// Warming the page cache for commands before they're run: the prefetch builtin and startup warm-up
+#define _GNU_SOURCE
+#include "./smallsh.h"
+#include <link.h>
+#include <glob.h>
+
+
+/*
+* Identifies a file that has been prefetched, so each file is only read once per job
+* (even through different paths or symlinks)
+*/
+struct PrefetchedFile {
+    dev_t device;
+    ino_t inode;
+};
+
+
+/*
+* The work for one prefetch thread
+* Everything the thread needs is copied into the job when it's made, so the thread
+* never touches smallsh's own state
+*/
+struct PrefetchJob {
+    // commands to prefetch
+    char** commandNames;
+    int commandCount;
+    int commandCapacity;
+
+    // text to find more command names in (lines of history or a script), or NULL
+    char* commandText;
+    int scriptFD;  // a script file to find more command names in, or -1
+
+    char* path;  // a copy of PATH
+    char* libraryPath;  // a copy of LD_LIBRARY_PATH
+
+    // directories the dynamic linker searches, from /etc/ld.so.conf and the defaults
+    char** libraryDirectories;
+    int libraryDirectoryCount;
+
+    struct PrefetchedFile* prefetchedFiles;
+    int prefetchedCount;
+};
+
+
+/*
+* Adds a string to a growing array of strings, unless it's already there
+* strings: the array
+* count: number of strings in the array
+* capacity: room in the array
+* string: the string, which is copied
+* length: length of the string (it doesn't have to be null-terminated)
+*/
+static void addUniqueString(char*** strings, int* count, int* capacity, const char* string, size_t length) {
+    for (int index = 0; index < *count; ++index) {
+        if (strlen((*strings)[index]) == length && strncmp((*strings)[index], string, length) == 0) {
+            return;
+        }
+    }
+
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 32;
+        *strings = realloc(*strings, *capacity * sizeof(char*));
+    }
+
+    (*strings)[*count] = strndup(string, length);
+    ++*count;
+
+    return;
+}
+
+
+/*
+* Finds the commands a line of smallsh input would run, and adds them to a job
+* Builtins are skipped, but the commands run by repeat, for, every, at, and batch are found
+* job: the job
+* line: the line (not null-terminated)
+* lineLength: length of the line
+*/
+static void addCommandNamesFromLine(struct PrefetchJob* job, const char* line, size_t lineLength) {
+    char* lineCopy = strndup(line, lineLength);
+    char* tokens[MAX_ARG_COUNT];
+    int tokenCount = 0;
+    char* indexPointer;
+
+    for (char* token = strtok_r(lineCopy, " \t", &indexPointer); token && tokenCount < MAX_ARG_COUNT;
+         token = strtok_r(NULL, " \t", &indexPointer)) {
+        tokens[tokenCount] = token;
+        ++tokenCount;
+    }
+
+    for (int tokenIndex = 0; tokenIndex < tokenCount; ++tokenIndex) {
+        char* command = tokens[tokenIndex];
+        bool isBuiltin = false;
+
+        // comments and redirections aren't commands
+        if (command[0] == '#' || command[0] == '<' || command[0] == '>' || command[0] == '!') {
+            break;
+        }
+
+        // commands that run another command: skip to the command they run
+        if (isEqualString(command, "repeat") || isEqualString(command, "every") || isEqualString(command, "at")) {
+            ++tokenIndex;
+            continue;
+        } else if (isEqualString(command, "batch")) {
+            while (tokenIndex + 2 < tokenCount && tokens[tokenIndex + 1][0] == '-') {
+                tokenIndex += 2;
+            }
+            continue;
+        } else if (isEqualString(command, "for")) {
+            while (tokenIndex + 1 < tokenCount && !isEqualString(tokens[tokenIndex], "do")) {
+                ++tokenIndex;
+            }
+            continue;
+        }
+
+        for (int index = 0; GLOBAL_builtinCommands[index]; ++index) {
+            if (isEqualString(command, (char*) GLOBAL_builtinCommands[index])) {
+                isBuiltin = true;
+            }
+        }
+
+        if (!isBuiltin) {
+            addUniqueString(&job->commandNames, &job->commandCount, &job->commandCapacity, command, strlen(command));
+        }
+
+        break;
+    }
+
+    free(lineCopy);
+
+    return;
+}
+
+
+/*
+* Finds the commands every line of some text would run, and adds them to a job
+* job: the job
+* text: the lines
+* length: length of the text
+*/
+static void addCommandNamesFromText(struct PrefetchJob* job, const char* text, size_t length) {
+    const char* textEnd = text + length;
+
+    while (text < textEnd) {
+        const char* lineEnd = memchr(text, '\n', textEnd - text);
+        lineEnd = lineEnd ? lineEnd : textEnd;
+
+        if (lineEnd > text) {
+            addCommandNamesFromLine(job, text, lineEnd - text);
+        }
+
+        text = lineEnd + 1;
+    }
+
+    return;
+}
+
+
+/*
+* Adds the directories listed in a dynamic linker config file (like /etc/ld.so.conf)
+* to a job's library search path, following its include lines
+* job: the job
+* configPath: the config file
+* depth: how many includes deep this file is (to stop include loops)
+*/
+static void addLibraryDirectoriesFromConfig(struct PrefetchJob* job, const char* configPath, int depth) {
+    FILE* configFile = depth < 8 ? fopen(configPath, "re") : NULL;
+    char* line = NULL;
+    size_t lineCapacity = 0;
+    int capacity = job->libraryDirectoryCount;
+
+    if (!configFile) {
+        return;
+    }
+
+    while (getline(&line, &lineCapacity, configFile) != -1) {
+        // drop comments and surrounding whitespace
+        line[strcspn(line, "#\n")] = '\0';
+        char* entry = line + strspn(line, " \t");
+        size_t wordLength = strcspn(entry, " \t");
+
+        if (wordLength == 7 && strncmp(entry, "include", 7) == 0) {
+            // include takes a glob pattern, after the word include
+            char* pattern = entry + wordLength + strspn(entry + wordLength, " \t");
+            pattern[strcspn(pattern, " \t")] = '\0';
+            glob_t matches;
+
+            if (glob(pattern, 0, NULL, &matches) == 0) {
+                for (size_t match = 0; match < matches.gl_pathc; ++match) {
+                    addLibraryDirectoriesFromConfig(job, matches.gl_pathv[match], depth + 1);
+                }
+            }
+
+            globfree(&matches);
+            capacity = job->libraryDirectoryCount;
+        } else if (entry[0] == '/') {
+            entry[wordLength] = '\0';
+
+            if (job->libraryDirectoryCount >= capacity) {
+                capacity = job->libraryDirectoryCount + 16;
+                job->libraryDirectories = realloc(job->libraryDirectories, capacity * sizeof(char*));
+            }
+
+            job->libraryDirectories[job->libraryDirectoryCount] = strdup(entry);
+            ++job->libraryDirectoryCount;
+        }
+    }
+
+    free(line);
+    fclose(configFile);
+
+    return;
+}
+
+
+/*
+* Finds a file in a colon-separated list of directories
+* directories: the list (like PATH)
+* name: the file's name
+* accessMode: what the file must allow, like X_OK
+* origin: what $ORIGIN in the list means (the directory of the file that asked), or NULL
+* return: the file's path, or NULL if it isn't in any of the directories
+*/
+static char* findInDirectoryList(const char* directories, const char* name, int accessMode, const char* origin) {
+    char* path = calloc(MAX_FILEPATH_LENGTH + 1, sizeof(char));
+    const char* directory = directories;
+
+    while (directory && *directory) {
+        size_t directoryLength = strcspn(directory, ":");
+
+        if (origin && strncmp(directory, "$ORIGIN", 7) == 0) {
+            snprintf(path, MAX_FILEPATH_LENGTH, "%s%.*s/%s", origin, (int) directoryLength - 7, directory + 7, name);
+        } else {
+            snprintf(path, MAX_FILEPATH_LENGTH, "%.*s/%s", (int) directoryLength, directory, name);
+        }
+
+        struct stat fileInfo;
+
+        if (directoryLength > 0 && stat(path, &fileInfo) == 0 && S_ISREG(fileInfo.st_mode) && access(path, accessMode) == 0) {
+            return path;
+        }
+
+        directory = directory[directoryLength] ? directory + directoryLength + 1 : NULL;
+    }
+
+    free(path);
+
+    return NULL;
+}
+
+
+/*
+* Reads a null-terminated string from a file
+* fd: the file
+* offset: where the string starts
+* return: the string (at most PATH_MAX chars), or NULL if it couldn't be read
+*/
+static char* readStringAt(int fd, off_t offset) {
+    char* string = calloc(PATH_MAX + 1, sizeof(char));
+
+    if (pread(fd, string, PATH_MAX, offset) <= 0) {
+        free(string);
+        return NULL;
+    }
+
+    return string;
+}
+
+
+static void prefetchFile(struct PrefetchJob* job, const char* path);
+
+
+/*
+* Finds a shared library the way the dynamic linker would, and prefetches it
+* job: the job
+* name: the library's name from DT_NEEDED (like libc.so.6)
+* runPath: the DT_RUNPATH or DT_RPATH of the file that needs it, or NULL
+* origin: the directory of the file that needs it, for $ORIGIN in runPath
+*/
+static void prefetchLibrary(struct PrefetchJob* job, const char* name, const char* runPath, const char* origin) {
+    char* libraryPath = NULL;
+
+    if (strchr(name, '/')) {
+        prefetchFile(job, name);
+        return;
+    }
+
+    // search the places the dynamic linker does (using ld.so.conf rather than its cache)
+    if (runPath) {
+        libraryPath = findInDirectoryList(runPath, name, R_OK, origin);
+    }
+
+    if (!libraryPath && job->libraryPath) {
+        libraryPath = findInDirectoryList(job->libraryPath, name, R_OK, NULL);
+    }
+
+    for (int index = 0; !libraryPath && index < job->libraryDirectoryCount; ++index) {
+        libraryPath = findInDirectoryList(job->libraryDirectories[index], name, R_OK, NULL);
+    }
+
+    if (!libraryPath) {
+        libraryPath = findInDirectoryList(PREFETCH_DEFAULT_LIBRARY_PATH, name, R_OK, NULL);
+    }
+
+    if (libraryPath) {
+        prefetchFile(job, libraryPath);
+        free(libraryPath);
+    }
+
+    return;
+}
+
+
+/*
+* Prefetches the program interpreter and shared libraries an ELF file needs
+* PT_INTERP names the interpreter (the dynamic linker). PT_DYNAMIC holds DT_NEEDED
+* entries, whose names are in the string table at DT_STRTAB, a virtual address that
+* the PT_LOAD segments map back to a file offset
+* job: the job
+* fd: the ELF file, open for reading
+* path: the ELF file's path
+*/
+static void prefetchElfDependencies(struct PrefetchJob* job, int fd, const char* path) {
+    ElfW(Ehdr) header;
+    ElfW(Phdr)* programHeaders;
+    ElfW(Dyn)* dynamicEntries = NULL;
+    size_t dynamicCount = 0;
+    ElfW(Addr) stringTableAddress = 0;
+    off_t stringTableOffset = -1;
+    size_t needed[PREFETCH_MAX_NEEDED];
+    int neededCount = 0;
+    ssize_t runPathIndex = -1;
+
+    // only ELF files of the same class as smallsh (others can't be run by its linker)
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || memcmp(header.e_ident, ELFMAG, SELFMAG) != 0
+            || header.e_ident[EI_CLASS] != (sizeof(void*) == 8 ? ELFCLASS64 : ELFCLASS32)
+            || header.e_phentsize != sizeof(ElfW(Phdr)) || header.e_phnum == 0) {
+        return;
+    }
+
+    programHeaders = calloc(header.e_phnum, sizeof(ElfW(Phdr)));
+
+    if (pread(fd, programHeaders, header.e_phnum * sizeof(ElfW(Phdr)), header.e_phoff)
+            != (ssize_t) (header.e_phnum * sizeof(ElfW(Phdr)))) {
+        free(programHeaders);
+        return;
+    }
+
+    for (int index = 0; index < header.e_phnum; ++index) {
+        ElfW(Phdr)* programHeader = &programHeaders[index];
+
+        if (programHeader->p_type == PT_INTERP) {
+            // the interpreter, like /lib64/ld-linux-x86-64.so.2
+            char* interpreter = readStringAt(fd, programHeader->p_offset);
+
+            if (interpreter) {
+                prefetchFile(job, interpreter);
+                free(interpreter);
+            }
+        } else if (programHeader->p_type == PT_DYNAMIC && !dynamicEntries) {
+            dynamicCount = programHeader->p_filesz / sizeof(ElfW(Dyn));
+            dynamicEntries = calloc(dynamicCount + 1, sizeof(ElfW(Dyn)));
+
+            if (pread(fd, dynamicEntries, dynamicCount * sizeof(ElfW(Dyn)), programHeader->p_offset) <= 0) {
+                dynamicCount = 0;
+            }
+        }
+    }
+
+    // collect the DT_NEEDED names' offsets in the string table
+    for (size_t index = 0; index < dynamicCount && dynamicEntries[index].d_tag != DT_NULL; ++index) {
+        ElfW(Dyn)* entry = &dynamicEntries[index];
+
+        if (entry->d_tag == DT_NEEDED && neededCount < PREFETCH_MAX_NEEDED) {
+            needed[neededCount] = entry->d_un.d_val;
+            ++neededCount;
+        } else if (entry->d_tag == DT_STRTAB) {
+            stringTableAddress = entry->d_un.d_ptr;
+        } else if (entry->d_tag == DT_RUNPATH || (entry->d_tag == DT_RPATH && runPathIndex == -1)) {
+            runPathIndex = entry->d_un.d_val;
+        }
+    }
+
+    // find the string table in the file
+    for (int index = 0; index < header.e_phnum; ++index) {
+        ElfW(Phdr)* programHeader = &programHeaders[index];
+
+        if (programHeader->p_type == PT_LOAD && stringTableAddress >= programHeader->p_vaddr
+                && stringTableAddress < programHeader->p_vaddr + programHeader->p_filesz) {
+            stringTableOffset = stringTableAddress - programHeader->p_vaddr + programHeader->p_offset;
+            break;
+        }
+    }
+
+    if (stringTableOffset != -1) {
+        char* runPath = runPathIndex != -1 ? readStringAt(fd, stringTableOffset + runPathIndex) : NULL;
+        char* origin = strdup(path);
+        char* lastSlash = strrchr(origin, '/');
+
+        if (lastSlash) {
+            *lastSlash = '\0';
+        }
+
+        // prefetch each needed library (and, recursively, the libraries it needs)
+        for (int index = 0; index < neededCount; ++index) {
+            char* name = readStringAt(fd, stringTableOffset + needed[index]);
+
+            if (name) {
+                prefetchLibrary(job, name, runPath, origin);
+                free(name);
+            }
+        }
+
+        free(runPath);
+        free(origin);
+    }
+
+    free(dynamicEntries);
+    free(programHeaders);
+
+    return;
+}
+
+
+/*
+* Prefetches the interpreter a script names on its #! line (like /bin/sh)
+* job: the job
+* fd: the file, open for reading
+*/
+static void prefetchScriptInterpreter(struct PrefetchJob* job, int fd) {
+    char firstLine[PATH_MAX + 1] = {0};
+
+    if (pread(fd, firstLine, PATH_MAX, 0) < 3 || strncmp(firstLine, "#!", 2) != 0) {
+        return;
+    }
+
+    // the interpreter is the first word after #!
+    char* interpreter = firstLine + 2 + strspn(firstLine + 2, " \t");
+    interpreter[strcspn(interpreter, " \t\n")] = '\0';
+
+    if (interpreter[0] == '/') {
+        prefetchFile(job, interpreter);
+    }
+
+    return;
+}
+
+
+/*
+* Starts reading a file into the page cache, then does the same for the interpreter
+* and libraries it needs, if it's an ELF file or a script
+* job: the job
+* path: the file
+*/
+static void prefetchFile(struct PrefetchJob* job, const char* path) {
+    struct stat fileInfo;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1 || fstat(fd, &fileInfo) == -1 || !S_ISREG(fileInfo.st_mode)) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return;
+    }
+
+    // skip files this job has already prefetched
+    for (int index = 0; index < job->prefetchedCount; ++index) {
+        if (job->prefetchedFiles[index].device == fileInfo.st_dev && job->prefetchedFiles[index].inode == fileInfo.st_ino) {
+            close(fd);
+            return;
+        }
+    }
+
+    job->prefetchedFiles = realloc(job->prefetchedFiles, (job->prefetchedCount + 1) * sizeof(struct PrefetchedFile));
+    job->prefetchedFiles[job->prefetchedCount] = (struct PrefetchedFile) {fileInfo.st_dev, fileInfo.st_ino};
+    ++job->prefetchedCount;
+
+    // readahead() fills the page cache without copying anything to smallsh;
+    // some filesystems don't support it, but take posix_fadvise() as a hint instead
+    if (readahead(fd, 0, fileInfo.st_size) == -1) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    }
+
+    prefetchElfDependencies(job, fd, path);
+    prefetchScriptInterpreter(job, fd);
+    close(fd);
+
+    return;
+}
+
+
+/*
+* Frees a prefetch job
+* job: the job
+*/
+static void freePrefetchJob(struct PrefetchJob* job) {
+    for (int index = 0; index < job->commandCount; ++index) {
+        free(job->commandNames[index]);
+    }
+
+    for (int index = 0; index < job->libraryDirectoryCount; ++index) {
+        free(job->libraryDirectories[index]);
+    }
+
+    if (job->scriptFD != -1) {
+        close(job->scriptFD);
+    }
+
+    free(job->commandNames);
+    free(job->commandText);
+    free(job->path);
+    free(job->libraryPath);
+    free(job->libraryDirectories);
+    free(job->prefetchedFiles);
+    free(job);
+
+    return;
+}
+
+
+/*
+* The prefetch thread: finds the commands in the job's text and script,
+* resolves each command through PATH, and prefetches it
+* argument: the PrefetchJob, which the thread frees
+* return: NULL
+*/
+static void* runPrefetchJob(void* argument) {
+    struct PrefetchJob* job = argument;
+
+    // find the commands a script would run (pread() leaves smallsh's place in it alone)
+    if (job->scriptFD != -1) {
+        char* script = calloc(PREFETCH_MAX_SCRIPT_LENGTH, sizeof(char));
+        ssize_t scriptLength = pread(job->scriptFD, script, PREFETCH_MAX_SCRIPT_LENGTH, 0);
+
+        if (scriptLength > 0) {
+            addCommandNamesFromText(job, script, scriptLength);
+        }
+
+        free(script);
+    }
+
+    if (job->commandText) {
+        addCommandNamesFromText(job, job->commandText, strlen(job->commandText));
+    }
+
+    addLibraryDirectoriesFromConfig(job, "/etc/ld.so.conf", 0);
+
+    // resolve and prefetch each command the same way execvp() would find it
+    for (int index = 0; index < job->commandCount; ++index) {
+        char* command = job->commandNames[index];
+
+        if (strchr(command, '/')) {
+            prefetchFile(job, command);
+        } else {
+            char* commandPath = findInDirectoryList(job->path, command, X_OK, NULL);
+
+            if (commandPath) {
+                prefetchFile(job, commandPath);
+                free(commandPath);
+            }
+        }
+    }
+
+    freePrefetchJob(job);
+
+    return NULL;
+}
+
+
+/*
+* Makes a new prefetch job, copying what its thread will need from the environment
+* return: the job
+*/
+static struct PrefetchJob* newPrefetchJob() {
+    struct PrefetchJob* job = calloc(1, sizeof(struct PrefetchJob));
+
+    job->scriptFD = -1;
+    job->path = strdup(getenv("PATH") ? getenv("PATH") : "/usr/local/bin:/usr/bin:/bin");
+    job->libraryPath = getenv("LD_LIBRARY_PATH") ? strdup(getenv("LD_LIBRARY_PATH")) : NULL;
+
+    return job;
+}
+
+
+/*
+* Adds a line to the end of a growing block of text
+* text: the text
+* textLength: length of the text
+* textCapacity: room for the text
+* line: the line (not null-terminated)
+* lineLength: length of the line
+*/
+static void appendLine(char** text, size_t* textLength, size_t* textCapacity, const char* line, size_t lineLength) {
+    if (*textLength + lineLength + 2 > *textCapacity) {
+        *textCapacity = (*textLength + lineLength + 2) * 2;
+        *text = realloc(*text, *textCapacity);
+    }
+
+    memcpy(*text + *textLength, line, lineLength);
+    *textLength += lineLength;
+    (*text)[(*textLength)++] = '\n';
+    (*text)[*textLength] = '\0';
+
+    return;
+}
+
+
+/*
+* Copies the most recent lines of history, as text with a line per entry
+* return: the lines (never NULL)
+*/
+static char* copyRecentHistory() {
+    size_t textLength = 0;
+    size_t textCapacity = 256;
+    char* text = calloc(textCapacity, sizeof(char));
+
+    if (GLOBAL_history.isIndexed) {
+        // the newest entries, from the index
+        int firstEntry = GLOBAL_history.entryCount > PREFETCH_HISTORY_LINES ? GLOBAL_history.entryCount - PREFETCH_HISTORY_LINES : 0;
+
+        for (int index = firstEntry; index < GLOBAL_history.entryCount; ++index) {
+            appendLine(&text, &textLength, &textCapacity, GLOBAL_history.entries[index].text, GLOBAL_history.entries[index].length);
+        }
+    } else {
+        // the end of the history file (found from the end, so it isn't indexed just for this),
+        // then the entries added since it was loaded
+        const char* fileStart = GLOBAL_history.mappedFile;
+        const char* fileEnd = fileStart + GLOBAL_history.mappedLength;
+        const char* tailStart = fileEnd;
+        int tailLines = 0;
+
+        while (tailStart > fileStart && tailLines <= PREFETCH_HISTORY_LINES) {
+            --tailStart;
+            tailLines += *tailStart == '\n';
+        }
+
+        if (tailStart < fileEnd) {
+            appendLine(&text, &textLength, &textCapacity, tailStart, fileEnd - tailStart);
+        }
+
+        for (int index = 0; index < GLOBAL_history.pendingCount; ++index) {
+            appendLine(&text, &textLength, &textCapacity, GLOBAL_history.pendingEntries[index],
+                       strlen(GLOBAL_history.pendingEntries[index]));
+        }
+    }
+
+    return text;
+}
+
+
+/*
+* Runs a prefetch job on a new background thread, which frees the job when it's done
+* The thread blocks every signal, so signals still interrupt smallsh's main thread
+* job: the job
+*/
+static void startPrefetchThread(struct PrefetchJob* job) {
+    pthread_t thread;
+    pthread_attr_t attributes;
+    sigset_t allSignals;
+    sigset_t originalMask;
+
+    sigfillset(&allSignals);
+    pthread_sigmask(SIG_SETMASK, &allSignals, &originalMask);
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    if (pthread_create(&thread, &attributes, runPrefetchJob, job) != 0) {
+        freePrefetchJob(job);
+    }
+
+    pthread_attr_destroy(&attributes);
+    pthread_sigmask(SIG_SETMASK, &originalMask, NULL);
+
+    return;
+}
+
+
+/*
+* Starts warming the page cache for the commands smallsh is likely to run, if
+* $SMALLSH_PREFETCH is set: the commands in recent history, and, when smallsh is
+* reading a script file, the commands in the script
+* Call it after loadHistory()
+*/
+void startWarmUp() {
+    struct stat inputInfo;
+
+    if (!getenv(PREFETCH_ENV_VAR)) {
+        return;
+    }
+
+    struct PrefetchJob* job = newPrefetchJob();
+    job->commandText = copyRecentHistory();
+
+    // a script on stdin can be read ahead of smallsh, without moving its offset
+    if (fstat(STDIN_FILENO, &inputInfo) == 0 && S_ISREG(inputInfo.st_mode)) {
+        job->scriptFD = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 3);
+    }
+
+    startPrefetchThread(job);
+
+    return;
+}
+
+
+/*
+* Warms the page cache for commands, so their first run doesn't wait on the disk
+* (or the network, for NFS)
+* prefetch             prefetches the commands in recent history
+* prefetch -f FILE     prefetches the commands a script runs
+* prefetch command...  prefetches the given commands
+* Each command's executable, its interpreter, and its shared libraries are read
+* ahead on a background thread, so this returns right away
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handlePrefetchCommand(struct CommandLine* commandLine) {
+    struct PrefetchJob* job = newPrefetchJob();
+
+    if (commandLine->argCount == 0) {
+        job->commandText = copyRecentHistory();
+    } else if (isEqualString(commandLine->args[0], "-f")) {
+        job->scriptFD = commandLine->argCount >= 2 ? open(commandLine->args[1], O_RDONLY | O_CLOEXEC) : -1;
+
+        if (job->scriptFD == -1) {
+            printf("cannot open %s for input\n", commandLine->argCount >= 2 ? commandLine->args[1] : "");
+            fflush(NULL);
+            freePrefetchJob(job);
+            GLOBAL_lastForegroundChildStatus = 1;
+            return;
+        }
+    } else {
+        for (int index = 0; index < commandLine->argCount; ++index) {
+            addUniqueString(&job->commandNames, &job->commandCount, &job->commandCapacity,
+                            commandLine->args[index], strlen(commandLine->args[index]));
+        }
+    }
+
+    startPrefetchThread(job);
+    GLOBAL_lastForegroundChildStatus = 0;
+
+    return;
+}
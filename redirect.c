@@ -0,0 +1,233 @@
+// Redirection of standard streams to files and here-documents
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* Opens a file and puts it in place of a standard stream
+* The file is opened close-on-exec, and its extra descriptor is closed once it has been
+* duplicated, so no descriptor but the standard stream itself is left behind
+* path: the file to open
+* openFlags: flags for open(), like O_RDONLY
+* streamFD: the standard stream to replace (0, 1, or 2)
+* return: 0 on success; -1 on failure, after printing why
+*/
+static int redirectStream(char* path, int openFlags, int streamFD) {
+    // open the file
+    int fileFD = open(path, openFlags | O_CLOEXEC, 0644);
+
+    if (fileFD == -1) { 
+        // to stderr, since stdout may be the stream being redirected
+        const char* streamName = streamFD == STDIN_FILENO ? "input" : streamFD == STDOUT_FILENO ? "output" : "errors";
+        fprintf(stderr, "cannot open %s for %s: %s\n", path, streamName, strerror(errno));
+        fflush(NULL);
+        return -1;
+    }
+
+    if (fileFD == streamFD) {
+        // the stream was closed, so open() already put the file there.
+        // It just needs to be inherited by exec'd programs
+        fcntl(fileFD, F_SETFD, 0);
+        return 0;
+    }
+
+    // redirect the stream to the file (the copy made by dup2() isn't close-on-exec)
+    int result = dup2(fileFD, streamFD);
+    close(fileFD);
+
+    if (result == -1) {
+        printToTerminal("couldn't redirect a stream to a file via dup2(), but it was a good file\n", true);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+* Puts a here-document (or here-string) in place of stdin, without touching the file system
+* Text up to PIPE_BUF bytes goes through a pipe, which can hold it without blocking.
+* Larger text goes in a sealed memfd, which the reader sees as an ordinary read-only file
+* text: the here-document's text
+* length: number of chars in text
+* return: 0 on success; -1 on failure, after printing why
+*/
+static int redirectHereDocument(char* text, int length) {
+    int documentFD;
+    int pipeFDs[2];
+
+    if (length <= PIPE_BUF) {
+        if (pipe2(pipeFDs, O_CLOEXEC) == -1) {
+            printToTerminal("couldn't create a pipe for a here-document", true);
+            return -1;
+        }
+
+        // the whole text fits in the pipe, so the write end can be closed right away
+        write(pipeFDs[1], text, length);
+        close(pipeFDs[1]);
+        documentFD = pipeFDs[0];
+    } else {
+        documentFD = memfd_create("smallsh-here-document", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        if (documentFD == -1) {
+            printToTerminal("couldn't create a memfd for a here-document", true);
+            return -1;
+        }
+
+        // write the text, then seal the file so the reader can't change it
+        for (int written = 0; written < length; ) {
+            int result = write(documentFD, text + written, length - written);
+
+            if (result == -1) {
+                printToTerminal("couldn't write a here-document", true);
+                close(documentFD);
+                return -1;
+            }
+
+            written += result;
+        }
+
+        lseek(documentFD, 0, SEEK_SET);
+        fcntl(documentFD, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL);
+    }
+
+    // put it in place of stdin (the copy made by dup2() isn't close-on-exec)
+    int result = dup2(documentFD, STDIN_FILENO);
+    close(documentFD);
+
+    if (result == -1) {
+        printToTerminal("couldn't redirect stdin to a here-document via dup2()\n", true);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+* Redirects stdin to point to a given file
+* If sourceFile isn't provided, stdin will be redirected to /dev/null
+* sourceFile: path of the file to use for stdin
+* return: 0 on success; -1 on failure, after printing why
+* (adapted from lesson material)
+* (source of courage to open /dev/null: https://stackoverflow.com/a/14846891/14257952)
+*/
+int redirectStdin(char* sourceFile) {
+    // check for redirecting to /dev/null
+    char* redirectPath = sourceFile ? sourceFile : "/dev/null";
+
+    return redirectStream(redirectPath, O_RDONLY, STDIN_FILENO);
+}
+
+
+/*
+* Redirects stdout to point to a given file
+* If outputFile isn't provided, stdout will be redirected to /dev/null
+* outputFile: path of the file to use for stdout
+* return: 0 on success; -1 on failure, after printing why
+* (adapted from lesson material)
+* (source of courage to open /dev/null: https://stackoverflow.com/a/14846891/14257952)
+*/
+static int redirectStdout(char* outputFile) {
+    // check for redirecting to /dev/null
+    char* redirectPath = outputFile ? outputFile : "/dev/null";
+
+    return redirectStream(redirectPath, O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO);
+}
+
+
+/*
+* Applies all of a command line's redirections to this process's standard streams
+* stdout is redirected before stderr, so 2>&1 sends stderr wherever stdout ends up
+* commandLine: pointer to a CommandLine struct which has the command line's details
+* isBackground: if true, stdin and stdout that aren't redirected go to /dev/null (per specs)
+* return: 0 on success; -1 if any redirection failed, after printing why
+*/
+int applyRedirections(struct CommandLine* commandLine, bool isBackground) {
+    // Redirect input if the user asked to (a here-document takes the place of a file)
+    // Else, if it's background, suppress input (per specs)
+    if (commandLine->hereDocument) {
+        if (redirectHereDocument(commandLine->hereDocument, commandLine->hereDocumentLength) == -1) {
+            return -1;
+        }
+    } else if (commandLine->inFile) {
+        int inputFlags = commandLine->isInFileWritable ? O_RDWR | O_CREAT : O_RDONLY;
+
+        if (redirectStream(commandLine->inFile, inputFlags, STDIN_FILENO) == -1) {
+            return -1;
+        }
+    } else if (isBackground && redirectStdin(NULL) == -1) {
+        return -1;
+    }
+
+    // Redirect output if the user asked to
+    // Else, if it's background, suppress output (per specs)
+    if (commandLine->outFile) {
+        int outputFlags = O_WRONLY | O_CREAT | (commandLine->isOutAppend ? O_APPEND : O_TRUNC);
+
+        if (redirectStream(commandLine->outFile, outputFlags, STDOUT_FILENO) == -1) {
+            return -1;
+        }
+    } else if (isBackground && redirectStdout(NULL) == -1) {
+        return -1;
+    }
+
+    // redirect errors to a file, or to wherever output goes
+    if (commandLine->errFile) {
+        int errorFlags = O_WRONLY | O_CREAT | (commandLine->isErrAppend ? O_APPEND : O_TRUNC);
+
+        if (redirectStream(commandLine->errFile, errorFlags, STDERR_FILENO) == -1) {
+            return -1;
+        }
+    } else if (commandLine->isErrToOut && dup2(STDOUT_FILENO, STDERR_FILENO) == -1) {
+        printToTerminal("couldn't redirect stderr to stdout via dup2()\n", true);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*
+* Applies a builtin command's redirections to smallsh itself, first saving the
+* standard streams that will change so restoreStandardStreams() can put them back
+* Only the streams being redirected are saved, to keep this to a few system calls
+* commandLine: pointer to a CommandLine struct which has the command line's details
+* savedStreams: set to the saved copy of each standard stream, or -1 if it wasn't saved
+* return: 0 on success; -1 if any redirection failed, after printing why
+*/
+int redirectStandardStreams(struct CommandLine* commandLine, int savedStreams[3]) {
+    bool isRedirected[3] = {
+        commandLine->inFile != NULL || commandLine->hereDocument != NULL,
+        commandLine->outFile != NULL,
+        commandLine->errFile != NULL || commandLine->isErrToOut
+    };
+
+    // flush anything already buffered for the original streams
+    fflush(NULL);
+
+    for (int streamFD = 0; streamFD < 3; ++streamFD) {
+        // the copy is close-on-exec, so it isn't inherited by children of the builtin
+        savedStreams[streamFD] = isRedirected[streamFD] ? fcntl(streamFD, F_DUPFD_CLOEXEC, 10) : -1;
+    }
+
+    return applyRedirections(commandLine, false);
+}
+
+
+/*
+* Puts back the standard streams saved by redirectStandardStreams()
+* savedStreams: the saved copy of each standard stream, or -1 if it wasn't saved
+*/
+void restoreStandardStreams(int savedStreams[3]) {
+    // flush anything buffered for the redirected streams
+    fflush(NULL);
+
+    for (int streamFD = 0; streamFD < 3; ++streamFD) {
+        if (savedStreams[streamFD] != -1) {
+            dup2(savedStreams[streamFD], streamFD);
+            close(savedStreams[streamFD]);
+        }
+    }
+
+    return;
+}
@@ -0,0 +1,150 @@
+// Signal handling for smallsh and its children
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+volatile sig_atomic_t GLOBAL_receivedSIGINT = 0;
+
+
+/*
+* ignores a SIGINT signal (when a process receives a ctrl+C interrupt signal)
+* signalNumber: used by sigaction() internally
+*/
+static void ignoreSIGINT(int signalNumber) {
+    // do nothing (besides noting it), overriding default SIGINT handler behavior
+    GLOBAL_receivedSIGINT = 1;
+    //char* debugMessage = "DEBUG: Caught SIGINT, ignoring\n";
+	//write(STDOUT_FILENO, debugMessage, 31);
+    //fflush(NULL);
+
+    return;
+}
+
+
+/*
+* ignores a SIGTSTP signal (when a process receives a ctrl+Z signal)
+* signalNumber: used by sigaction() internally
+*/
+static void handleSIGTSTP(int signalNumber) {
+    char* notice;
+
+    if (!GLOBAL_fgOnlyMode) {
+        // print a message that foreground-only mode will be turned on
+        notice = "Entering foreground-only mode (& is now ignored)\n";
+    } else {
+        // print a message that foreground-only mode will be turned off
+        notice = "Exiting foreground-only mode\n";
+    }
+
+    // get length of notice
+    int noticeLength = 0;
+    char* checkCharPointer = notice;
+    while (*checkCharPointer != '\0') {
+        ++noticeLength;
+        ++checkCharPointer;
+    }
+
+    write(STDOUT_FILENO, notice, noticeLength);  // strlen() isn't reentrant
+    fflush(NULL);
+
+    // toggle foreground-only mode
+    GLOBAL_fgOnlyMode = !GLOBAL_fgOnlyMode;
+
+    return;
+}
+
+
+/*
+* ignores a SIGTSTP signal (when a process receives a ctrl+Z signal)
+* signalNumber: used by sigaction() internally
+*/
+static void ignoreSIGTSTP(int signalNumber) {
+    // do nothing, overriding default SIGTSTP handler behavior
+
+    return;
+}
+
+
+/*
+* does setup to enable SIGTSTP signals to be handled by custom functions
+* (adapted from lecture material)
+* ignore: if true, ignoreSIGTSTP will handle the signal; if false, handleSIGTSTP will
+*/
+void setSIGTSTPhandler(bool ignore) {
+    // initialize empty sigaction
+    struct sigaction SIGTSTPaction = {{0}};  // gcc bug: https://stackoverflow.com/a/13758286/14257952
+
+    // register handler function
+    SIGTSTPaction.sa_handler = ignore ? ignoreSIGTSTP : handleSIGTSTP;
+
+    // block all catchable signals while handler is running
+	sigfillset(&SIGTSTPaction.sa_mask);
+
+    // make no flags set
+	SIGTSTPaction.sa_flags = 0;
+
+    // install the handler to associate the handler with the signal
+    sigaction(SIGTSTP, &SIGTSTPaction, NULL);
+
+    return;
+}
+
+
+/*
+* does setup to enable ignoreSIGINT to catch SIGINT signals
+* (adapted from lecture material)
+*/
+void setSIGINThandler() {
+    // initialize empty sigaction
+    struct sigaction SIGINTaction = {{0}};  // gcc bug: https://stackoverflow.com/a/13758286/14257952
+
+    // register handler function
+    SIGINTaction.sa_handler = ignoreSIGINT;
+
+    // block all catchable signals while handler is running
+	sigfillset(&SIGINTaction.sa_mask);
+
+    // make no flags set
+	SIGINTaction.sa_flags = 0;
+
+    // install the handler to associate the handler with the signal
+    sigaction(SIGINT, &SIGINTaction, NULL);
+
+    return;
+}
+
+
+/*
+* resets SIGINT signal handling behavior to default
+* (adapted from lecture material)
+* (inspired by https://stackoverflow.com/a/24804019/14257952)
+*/
+void resetSIGINThandler() {
+    // initialize empty sigaction
+    struct sigaction SIGINTaction = {{0}};  // gcc bug: https://stackoverflow.com/a/13758286/14257952
+
+    // register handler function back to default
+    SIGINTaction.sa_handler = SIG_DFL;
+
+    // block all catchable signals while handler is running
+	sigfillset(&SIGINTaction.sa_mask);
+
+    // make no flags set
+	SIGINTaction.sa_flags = 0;
+
+    // install the handler to associate the handler with the signal
+    sigaction(SIGINT, &SIGINTaction, NULL);
+
+    return;
+}
+
+
+/*
+* registers signal handlers for a new background child process
+*/
+void registerNewBgChildSignals() {
+    // ignore sigint
+    setSIGINThandler();
+
+    return;
+}
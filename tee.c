@@ -0,0 +1,467 @@
+// Fanning output out to several files: the tee builtin and >+ redirection
+#define _GNU_SOURCE
+#include "./smallsh.h"
+
+
+/*
+* One destination of a fan-out
+*/
+struct TeeOutput {
+    int fd;
+    bool isOpen;  // false once a write to it fails; the other outputs carry on
+    bool canSplice;  // false once splice() to it fails with EINVAL; then it gets copies
+    int pipeFDs[2];  // holds its copy of each chunk, from tee(), until it's spliced to fd
+};
+
+
+/*
+* Writes a whole buffer, retrying short writes
+* fd: where to write
+* buffer: the bytes to write
+* length: number of bytes in buffer
+* return: 0 on success; -1 on failure
+*/
+static int writeFully(int fd, const char* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, buffer, length);
+
+        if (written == -1 && errno == EINTR) {
+            continue;
+        } else if (written <= 0) {
+            return -1;
+        }
+
+        buffer += written;
+        length -= written;
+    }
+
+    return 0;
+}
+
+
+/*
+* Moves up to length bytes from a pipe to an output, with splice() if the output
+* supports it, or by copying through a buffer if it doesn't
+* pipeFD: read end of the pipe
+* output: the destination
+* length: most bytes to move
+* buffer: TEE_BUFFER_SIZE bytes of space for copying
+* return: bytes moved; 0 at the end of the pipe's input; -1 if the output failed
+*/
+static ssize_t moveChunk(int pipeFD, struct TeeOutput* output, size_t length, char* buffer) {
+    ssize_t moved;
+
+    while (true) {
+        if (output->canSplice) {
+            moved = splice(pipeFD, NULL, output->fd, NULL, length, SPLICE_F_MOVE);
+
+            // splice() fails with EINVAL for outputs that don't support it, like terminals
+            if (moved == -1 && errno == EINVAL) {
+                output->canSplice = false;
+                continue;
+            }
+        } else {
+            moved = read(pipeFD, buffer, length < TEE_BUFFER_SIZE ? length : TEE_BUFFER_SIZE);
+
+            if (moved > 0 && writeFully(output->fd, buffer, moved) == -1) {
+                return -1;
+            }
+        }
+
+        if (moved == -1 && errno == EINTR) {
+            continue;
+        }
+
+        return moved;
+    }
+}
+
+
+/*
+* Throws away bytes waiting in a pipe
+* pipeFD: read end of the pipe
+* length: number of bytes to throw away
+* buffer: TEE_BUFFER_SIZE bytes of space
+*/
+static void discardFromPipe(int pipeFD, size_t length, char* buffer) {
+    while (length > 0) {
+        ssize_t discarded = read(pipeFD, buffer, length < TEE_BUFFER_SIZE ? length : TEE_BUFFER_SIZE);
+
+        if (discarded == -1 && errno == EINTR) {
+            continue;
+        } else if (discarded <= 0) {
+            break;
+        }
+
+        length -= discarded;
+    }
+
+    return;
+}
+
+
+/*
+* Moves exactly length bytes from a pipe to an output
+* If the output fails, it's closed, and the rest of the bytes are thrown away
+* pipeFD: read end of the pipe
+* output: the destination
+* length: number of bytes to move
+* buffer: TEE_BUFFER_SIZE bytes of space for copying
+*/
+static void moveFully(int pipeFD, struct TeeOutput* output, size_t length, char* buffer) {
+    while (length > 0) {
+        ssize_t moved = moveChunk(pipeFD, output, length, buffer);
+
+        if (moved <= 0) {
+            output->isOpen = false;
+            discardFromPipe(pipeFD, length, buffer);
+            break;
+        }
+
+        length -= moved;
+    }
+
+    return;
+}
+
+
+/*
+* Copies everything from a file or terminal to several outputs through a buffer,
+* for input that isn't a pipe (tee() only works on pipes)
+* inputFD: where to read from, if isShellInput is false
+* isShellInput: if true, smallsh's own input is read instead, a line at a time with
+*               getInputLine(), so input smallsh has already buffered isn't skipped
+* outputs: the destinations
+* outputCount: number of outputs
+* buffer: TEE_BUFFER_SIZE bytes of space for copying
+*/
+static void copyToOutputs(int inputFD, bool isShellInput, struct TeeOutput* outputs, int outputCount, char* buffer) {
+    char* line = NULL;
+    size_t lineCapacity = 0;
+
+    while (true) {
+        char* data = buffer;
+        ssize_t length;
+
+        // read the next chunk (or line)
+        if (isShellInput) {
+            length = getInputLine(&line, &lineCapacity);
+            data = line;
+        } else {
+            length = read(inputFD, buffer, TEE_BUFFER_SIZE);
+
+            if (length == -1 && errno == EINTR) {
+                continue;
+            }
+        }
+
+        if (length <= 0) {
+            break;
+        }
+
+        // write it to every output
+        for (int index = 0; index < outputCount; ++index) {
+            if (outputs[index].isOpen && writeFully(outputs[index].fd, data, length) == -1) {
+                outputs[index].isOpen = false;
+            }
+        }
+    }
+
+    free(line);
+
+    return;
+}
+
+
+/*
+* Copies everything from a pipe to several outputs without copying through user space
+* Each round, tee() duplicates a chunk of the pipe's data into every output's own pipe
+* but the last, and splice() moves it from there to the output. Then the chunk itself
+* is spliced to the last output, which takes it out of the input pipe. Outputs that
+* can't be spliced to get the data through a large buffer instead.
+* Every output's pipe is at least as big as the input pipe, and empty at the start of
+* each round, so tee() always duplicates the whole chunk. If an output's pipe can't be
+* made that big (because of /proc/sys/fs/pipe-max-size or a per-user limit on pipe
+* memory), everything is copied through the buffer instead
+* inputFD: read end of the input pipe
+* outputs: the destinations
+* outputCount: number of outputs
+* buffer: TEE_BUFFER_SIZE bytes of space for copying
+*/
+static void spliceToOutputs(int inputFD, struct TeeOutput* outputs, int outputCount, char* buffer) {
+    int pipeSize = fcntl(inputFD, F_GETPIPE_SZ);
+
+    bool canTee = pipeSize > 0;
+
+    // give every output but the last its own pipe, as big as the input pipe
+    for (int index = 0; index < outputCount - 1 && canTee; ++index) {
+        if (pipe2(outputs[index].pipeFDs, O_CLOEXEC) == -1) {
+            outputs[index].pipeFDs[0] = -1;
+            canTee = false;
+        } else if (fcntl(outputs[index].pipeFDs[1], F_GETPIPE_SZ) < pipeSize
+                && fcntl(outputs[index].pipeFDs[1], F_SETPIPE_SZ, pipeSize) < pipeSize) {
+            canTee = false;
+        }
+    }
+
+    // a smaller pipe would get only part of a chunk, and tee() can't skip to the rest
+    if (!canTee) {
+        for (int index = 0; index < outputCount - 1; ++index) {
+            if (outputs[index].pipeFDs[0] != -1) {
+                close(outputs[index].pipeFDs[0]);
+                close(outputs[index].pipeFDs[1]);
+                outputs[index].pipeFDs[0] = -1;
+                outputs[index].pipeFDs[1] = -1;
+            }
+        }
+
+        copyToOutputs(inputFD, false, outputs, outputCount, buffer);
+        return;
+    }
+
+    while (true) {
+        size_t chunkLength = 0;  // set by the first tee() or splice() of each round
+        int lastOutput = -1;
+
+        // the last open output takes the chunk out of the input pipe
+        for (int index = 0; index < outputCount; ++index) {
+            if (outputs[index].isOpen) {
+                lastOutput = index;
+            }
+        }
+
+        // stop if every output has failed
+        if (lastOutput == -1) {
+            break;
+        }
+
+        // duplicate the chunk for every other output
+        for (int index = 0; index < lastOutput; ++index) {
+            if (!outputs[index].isOpen) {
+                continue;
+            }
+
+            ssize_t duplicated = tee(inputFD, outputs[index].pipeFDs[1], chunkLength ? chunkLength : pipeSize, 0);
+
+            if (duplicated == -1 && errno == EINTR) {
+                --index;
+                continue;
+            } else if (duplicated <= 0) {
+                // end of input (every writer has closed the pipe)
+                return;
+            }
+
+            chunkLength = duplicated;
+            moveFully(outputs[index].pipeFDs[0], &outputs[index], chunkLength, buffer);
+        }
+
+        // move the chunk itself to the last output
+        if (chunkLength > 0) {
+            moveFully(inputFD, &outputs[lastOutput], chunkLength, buffer);
+        } else {
+            // there's only one output, so the chunk is however much one splice() moves
+            ssize_t moved = moveChunk(inputFD, &outputs[lastOutput], pipeSize, buffer);
+
+            if (moved == 0) {
+                return;
+            } else if (moved == -1) {
+                outputs[lastOutput].isOpen = false;
+            }
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Opens the files a fan-out writes to, after the output it already has
+* outputs: filled with stdout and then the files
+* fileNames: the files
+* fileCount: number of files
+* isAppend: if true, the files are appended to instead of truncated
+* return: number of outputs, or -1 if a file couldn't be opened, after printing why
+*/
+static int openTeeOutputs(struct TeeOutput* outputs, char** fileNames, int fileCount, bool isAppend) {
+    int openFlags = O_WRONLY | O_CREAT | O_CLOEXEC | (isAppend ? O_APPEND : O_TRUNC);
+    int outputCount = 0;
+
+    // stdout is always an output
+    outputs[outputCount] = (struct TeeOutput) {STDOUT_FILENO, true, true, {-1, -1}};
+    ++outputCount;
+
+    for (int index = 0; index < fileCount; ++index) {
+        int fileFD = open(fileNames[index], openFlags, 0644);
+
+        if (fileFD == -1) {
+            fprintf(stderr, "cannot open %s for output: %s\n", fileNames[index], strerror(errno));
+            fflush(NULL);
+
+            for (int opened = 1; opened < outputCount; ++opened) {
+                close(outputs[opened].fd);
+            }
+
+            return -1;
+        }
+
+        outputs[outputCount] = (struct TeeOutput) {fileFD, true, true, {-1, -1}};
+        ++outputCount;
+    }
+
+    return outputCount;
+}
+
+
+/*
+* Closes a fan-out's files and the pipes it made
+* outputs: the destinations
+* outputCount: number of outputs
+*/
+static void closeTeeOutputs(struct TeeOutput* outputs, int outputCount) {
+    for (int index = 0; index < outputCount; ++index) {
+        if (outputs[index].fd != STDOUT_FILENO) {
+            close(outputs[index].fd);
+        }
+
+        if (outputs[index].pipeFDs[0] != -1) {
+            close(outputs[index].pipeFDs[0]);
+            close(outputs[index].pipeFDs[1]);
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Copies stdin to stdout and to files
+* tee [-a] file...
+* Piped input (like a here-document) is duplicated with tee() and splice(), so it
+* never passes through user space; other input is copied through a large buffer.
+* With -a, the files are appended to instead of truncated
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleTeeCommand(struct CommandLine* commandLine) {
+    struct TeeOutput outputs[MAX_ARG_COUNT + 1];
+    bool isAppend = commandLine->argCount > 0 && isEqualString(commandLine->args[0], "-a");
+    int firstFile = isAppend ? 1 : 0;
+    bool isInputRedirected = commandLine->inFile || commandLine->hereDocument;
+    struct stat inputStat;
+
+    int outputCount = openTeeOutputs(outputs, &commandLine->args[firstFile], commandLine->argCount - firstFile, isAppend);
+
+    if (outputCount == -1) {
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    // anything already printed must come before the copied input
+    fflush(NULL);
+
+    char* buffer = malloc(TEE_BUFFER_SIZE);
+
+    if (isInputRedirected && fstat(STDIN_FILENO, &inputStat) == 0 && S_ISFIFO(inputStat.st_mode)) {
+        spliceToOutputs(STDIN_FILENO, outputs, outputCount, buffer);
+    } else if (isInputRedirected) {
+        copyToOutputs(STDIN_FILENO, false, outputs, outputCount, buffer);
+    } else {
+        // smallsh may already have buffered its input
+        copyToOutputs(-1, true, outputs, outputCount, buffer);
+    }
+
+    // update status
+    GLOBAL_lastForegroundChildStatus = 0;
+
+    for (int index = 0; index < outputCount; ++index) {
+        if (!outputs[index].isOpen) {
+            GLOBAL_lastForegroundChildStatus = 1;
+        }
+    }
+
+    closeTeeOutputs(outputs, outputCount);
+    free(buffer);
+
+    return;
+}
+
+
+/*
+* Sends a command's output to its >+ files as well as to its stdout
+* Called in the command's child process, after its other redirections. It forks: the
+* new process returns to exec the command, with stdout (and stderr, for 2>&1) going to
+* a pipe, and this process stays behind to fan the pipe's data out with tee() and
+* splice(), then exits with the command's status. Because smallsh waits for this
+* process, the command's output has all been written by the time the prompt returns
+* commandLine: pointer to a CommandLine struct which has the command line's details
+* return: 0 in the process that should exec the command; -1 on failure, after printing why
+*/
+int startTeeWorker(struct CommandLine* commandLine) {
+    struct TeeOutput outputs[MAX_ARG_COUNT + 1];
+    int pipeFDs[2];
+    int childStatus;
+
+    int outputCount = openTeeOutputs(outputs, commandLine->teeFiles, commandLine->teeFileCount, false);
+
+    if (outputCount == -1) {
+        return -1;
+    }
+
+    if (pipe2(pipeFDs, O_CLOEXEC) == -1) {
+        printToTerminal("couldn't create a pipe for >+", true);
+        return -1;
+    }
+
+    // a big pipe lets each tee() and splice() move more at once. The biggest allowed
+    // may be smaller (/proc/sys/fs/pipe-max-size), so settle for less if need be
+    for (int pipeSize = TEE_PIPE_SIZE; pipeSize > PIPE_BUF && fcntl(pipeFDs[1], F_SETPIPE_SZ, pipeSize) == -1; pipeSize /= 2) {
+    }
+
+    pid_t commandPid = fork();
+
+    switch (commandPid) {
+        case -1:
+            printToTerminal("fork() failed to create a child process\n", true);
+            return -1;
+
+        case 0:
+            // This process runs the command, writing to the pipe
+            dup2(pipeFDs[1], STDOUT_FILENO);
+
+            if (commandLine->isErrToOut && !commandLine->errFile) {
+                dup2(pipeFDs[1], STDERR_FILENO);
+            }
+
+            close(pipeFDs[0]);
+            close(pipeFDs[1]);
+
+            return 0;
+
+        default:
+            // This process fans the output out. It must see the command's output through
+            // to the end even if ctrl+C ends the command
+            signal(SIGINT, SIG_IGN);
+            close(pipeFDs[1]);
+
+            char* buffer = malloc(TEE_BUFFER_SIZE);
+            spliceToOutputs(pipeFDs[0], outputs, outputCount, buffer);
+
+            // the command gets SIGPIPE if every output failed
+            close(pipeFDs[0]);
+
+            while (waitpid(commandPid, &childStatus, 0) == -1 && errno == EINTR) {
+            }
+
+            // End the same way the command did, so the status command reports it.
+            // _exit() leaves the stdin stream alone; exit() would flush it, which seeks
+            // a script smallsh is reading back to where this process's copy had read up to
+            if (WIFEXITED(childStatus)) {
+                _exit(WEXITSTATUS(childStatus));
+            }
+
+            signal(WTERMSIG(childStatus), SIG_DFL);
+            raise(WTERMSIG(childStatus));
+            _exit(EXIT_FAILURE);
+    }
+
+    return -1;
+}
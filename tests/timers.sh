@@ -0,0 +1,71 @@
+#!/bin/bash
+# Regression tests for scheduled commands (every, at, timers, and cancel)
+# Each test pipes a script into smallsh and checks that it exits normally and prints
+# what's expected. Prints one line per test, and exits with 1 if any failed
+# usage: tests/timers.sh [path to smallsh]
+
+SMALLSH=$(realpath "${1:-./smallsh}")
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+failures=0
+
+# keep the tests from reading or growing the user's history
+export SMALLSH_HISTFILE=/dev/null
+unset SMALLSH_EVENTLOG SMALLSH_PREFETCH
+
+
+# runs a script through smallsh and checks its exit status and output
+# $1: test name
+# $2: script
+# $3: text the output must contain (an empty timers listing shows up as just its prompt)
+run_test() {
+    local output status
+    output=$(cd "$WORK_DIR" && printf '%s\n' "$2" | "$SMALLSH" 2>&1)
+    status=$?
+
+    if [[ $status -ne 0 ]]; then
+        echo "FAIL $1: smallsh exited with status $status"
+        failures=$((failures + 1))
+    elif [[ $output != *"$3"* ]]; then
+        echo "FAIL $1: output didn't contain '$3':"
+        echo "$output"
+        failures=$((failures + 1))
+    else
+        echo "ok   $1"
+    fi
+}
+
+
+# a scheduled cancel that cancels its own timer, while that timer's command is running
+run_test "at cancels itself" "at 100ms cancel 1
+sleep 0.3
+timers
+echo end" $'scheduled\n: : : end'
+
+run_test "every cancels itself" "every 100ms cancel 1
+sleep 0.35
+timers
+echo end" $'scheduled\n: : : end'
+
+run_test "cancel the same running timer twice" "at 100ms cancel 1 1
+sleep 0.3
+echo end" $'scheduled\n: : end'
+
+# cancelling a timer that's waiting in the wheel, so its command never runs
+run_test "cancel a waiting timer" "at 100ms touch cancelled_out
+cancel 1
+sleep 0.3
+timers
+test -e cancelled_out
+status" $'scheduled\n: : : : : exit value 1'
+
+# a scheduling builtin run again by a loop schedules the same redirections each time
+run_test "at in repeat keeps its redirection" "repeat 3 at 10ms echo R >> repeat_out
+sleep 0.3
+cat repeat_out" $'R\nR\nR'
+
+run_test "at in for keeps its redirection" "for f in a b; do at 10ms echo \$f >> for_out; done
+sleep 0.3
+sort for_out" $'a\nb'
+
+exit $((failures > 0))
@@ -0,0 +1,600 @@
+// Scheduled commands: every, at, timers, and cancel, run from a hierarchical timer wheel
+#define _GNU_SOURCE
+#include "./smallsh.h"
+#include <sys/timerfd.h>
+
+
+/*
+* A command scheduled by every or at
+*/
+struct ScheduledTimer {
+    int id;
+    long long expiryTick;  // wheel tick the timer fires on
+    long long intervalTicks;  // ticks between runs for every; 0 for at
+    struct CommandLine* commandLine;  // parsed once, when it was scheduled
+    char* commandString;  // for the timers command
+    struct ScheduledTimer* next;  // in its wheel slot
+    struct ScheduledTimer** previousNext;  // what points at it, so it can unlink itself; NULL while it runs
+    bool isCancelled;  // set if its own command cancels it while it runs; it's freed afterward
+};
+
+
+/*
+* The timer wheel
+* Level 0 has a slot per tick for the next TIMER_WHEEL_SLOTS ticks. Each higher level
+* has slots TIMER_WHEEL_SLOTS times as wide, and its timers cascade down a level when
+* their slot comes up. So adding and cancelling timers is O(1), and each tick only
+* touches the timers in one slot
+*/
+struct TimerWheel {
+    int timerFD;  // fires when the wheel next has work to do; -1 until the first timer
+    struct timespec startTime;  // when tick 0 was (CLOCK_MONOTONIC)
+    long long currentTick;
+    struct ScheduledTimer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+    // every timer by id, so cancel doesn't have to search the wheel
+    struct ScheduledTimer** timersById;
+    int idCapacity;
+    int nextId;
+    int timerCount;
+};
+
+
+static struct TimerWheel GLOBAL_timerWheel = {.timerFD = -1, .nextId = 1};
+
+
+/*
+* Gets the tick the wheel's clock is at now
+* return: ticks since the wheel started
+*/
+static long long getCurrentTick() {
+    return getElapsedNanoseconds(&GLOBAL_timerWheel.startTime) / (TIMER_TICK_MS * 1000000LL);
+}
+
+
+/*
+* Puts a timer in the wheel slot for its expiry tick
+* timer: the timer, which must not be in a slot
+*/
+static void insertTimer(struct ScheduledTimer* timer) {
+    long long currentTick = GLOBAL_timerWheel.currentTick;
+    long long expiryTick = timer->expiryTick;
+    int level = 0;
+
+    // A timer that's overdue fires on the next tick. (One due on this tick can only
+    // be cascading down during advanceTick(), which runs this tick's slot next)
+    if (expiryTick < currentTick) {
+        expiryTick = timer->expiryTick = currentTick + 1;
+    }
+
+    // find the lowest level whose range reaches the expiry tick
+    while (level < TIMER_WHEEL_LEVELS - 1
+           && expiryTick - currentTick >= 1LL << (TIMER_WHEEL_BITS * (level + 1))) {
+        ++level;
+    }
+
+    // timers past the top level's range wait in its farthest slot, and are
+    // put back in the right place when that slot comes up
+    if (expiryTick - currentTick >= 1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) {
+        expiryTick = currentTick + (1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    }
+
+    int slot = (expiryTick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    struct ScheduledTimer** head = &GLOBAL_timerWheel.slots[level][slot];
+
+    // push it on the front of the slot's list
+    timer->next = *head;
+    timer->previousNext = head;
+    if (*head) {
+        (*head)->previousNext = &timer->next;
+    }
+    *head = timer;
+
+    return;
+}
+
+
+/*
+* Takes a timer out of its wheel slot
+* timer: the timer
+*/
+static void unlinkTimer(struct ScheduledTimer* timer) {
+    *timer->previousNext = timer->next;
+
+    if (timer->next) {
+        timer->next->previousNext = timer->previousNext;
+    }
+
+    timer->next = NULL;
+    timer->previousNext = NULL;
+
+    return;
+}
+
+
+/*
+* Frees a timer and forgets its id
+* timer: the timer, which must not be in a slot
+*/
+static void freeTimer(struct ScheduledTimer* timer) {
+    GLOBAL_timerWheel.timersById[timer->id] = NULL;
+    --GLOBAL_timerWheel.timerCount;
+
+    freeCommandLine(timer->commandLine);
+    free(timer->commandString);
+    free(timer);
+
+    return;
+}
+
+
+/*
+* Moves the wheel forward one tick, cascading higher levels down and
+* running the timers that expire on the new tick
+*/
+static void advanceTick() {
+    long long tick = ++GLOBAL_timerWheel.currentTick;
+
+    // when a level wraps around, the next level's slot for this tick cascades down
+    for (int level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+        if ((tick & ((1LL << (TIMER_WHEEL_BITS * level)) - 1)) != 0) {
+            break;
+        }
+
+        int slot = (tick >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+        struct ScheduledTimer* timer = GLOBAL_timerWheel.slots[level][slot];
+        GLOBAL_timerWheel.slots[level][slot] = NULL;
+
+        while (timer) {
+            struct ScheduledTimer* nextTimer = timer->next;
+            insertTimer(timer);
+            timer = nextTimer;
+        }
+    }
+
+    // run the expired timers (a run can't add to this slot, because new timers
+    // expire on a later tick)
+    struct ScheduledTimer** head = &GLOBAL_timerWheel.slots[0][tick & (TIMER_WHEEL_SLOTS - 1)];
+
+    while (*head) {
+        struct ScheduledTimer* timer = *head;
+        unlinkTimer(timer);
+
+        executeBackgroundCommand(timer->commandLine);
+
+        if (timer->isCancelled) {
+            // the command was cancel, and it cancelled its own timer
+            freeTimer(timer);
+        } else if (timer->intervalTicks > 0) {
+            // every: schedule the next run, skipping any that were missed
+            // while smallsh was busy
+            timer->expiryTick += timer->intervalTicks;
+
+            if (timer->expiryTick <= getCurrentTick()) {
+                timer->expiryTick = getCurrentTick() + timer->intervalTicks;
+            }
+
+            insertTimer(timer);
+        } else {
+            // at: it only runs once
+            freeTimer(timer);
+        }
+    }
+
+    return;
+}
+
+
+/*
+* Finds the next tick the wheel has work to do on: either a level 0 timer expiring,
+* or a higher level's slot cascading down
+* return: the tick, or -1 if the wheel is empty
+*/
+static long long findNextEventTick() {
+    long long currentTick = GLOBAL_timerWheel.currentTick;
+    long long nextTick = -1;
+
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+        int shift = TIMER_WHEEL_BITS * level;
+
+        // the first non-empty slot after the current one, going around once
+        for (int distance = 1; distance <= TIMER_WHEEL_SLOTS; ++distance) {
+            long long slotStart = ((currentTick >> shift) + distance) << shift;
+
+            if (GLOBAL_timerWheel.slots[level][(slotStart >> shift) & (TIMER_WHEEL_SLOTS - 1)]) {
+                if (nextTick == -1 || slotStart < nextTick) {
+                    nextTick = slotStart;
+                }
+                break;
+            }
+        }
+    }
+
+    return nextTick;
+}
+
+
+/*
+* Sets the timerfd to fire when the wheel next has work to do, or stops it if
+* the wheel is empty, so smallsh doesn't wake up for ticks with nothing to do
+*/
+static void armTimerFD() {
+    struct itimerspec expiry = {{0}};  // all zeros disarms it
+    long long nextTick = findNextEventTick();
+
+    if (nextTick != -1) {
+        long long nanoseconds = nextTick * TIMER_TICK_MS * 1000000LL;
+
+        // the time is absolute, measured from when the wheel started
+        expiry.it_value.tv_sec = GLOBAL_timerWheel.startTime.tv_sec + nanoseconds / 1000000000LL;
+        expiry.it_value.tv_nsec = GLOBAL_timerWheel.startTime.tv_nsec + nanoseconds % 1000000000LL;
+
+        if (expiry.it_value.tv_nsec >= 1000000000L) {
+            ++expiry.it_value.tv_sec;
+            expiry.it_value.tv_nsec -= 1000000000L;
+        }
+    }
+
+    timerfd_settime(GLOBAL_timerWheel.timerFD, TFD_TIMER_ABSTIME, &expiry, NULL);
+
+    return;
+}
+
+
+/*
+* Runs every scheduled command that has come due
+* Cheap to call when nothing is due: it only reads the clock
+*/
+void runDueTimers() {
+    uint64_t expirations;
+
+    if (GLOBAL_timerWheel.timerFD == -1) {
+        return;
+    }
+
+    // clear the timerfd's readiness (it's non-blocking)
+    read(GLOBAL_timerWheel.timerFD, &expirations, sizeof(expirations));
+
+    // Catch the wheel up to the clock. Ticks with nothing to do are skipped, so
+    // this costs the same after an hour as after a tick
+    long long currentTick = getCurrentTick();
+    bool hasAdvanced = GLOBAL_timerWheel.currentTick < currentTick;
+
+    while (GLOBAL_timerWheel.currentTick < currentTick) {
+        long long nextEventTick = findNextEventTick();
+
+        if (nextEventTick == -1 || nextEventTick > currentTick) {
+            GLOBAL_timerWheel.currentTick = currentTick;
+            break;
+        }
+
+        GLOBAL_timerWheel.currentTick = nextEventTick - 1;
+        advanceTick();
+    }
+
+    if (hasAdvanced) {
+        armTimerFD();
+    }
+
+    return;
+}
+
+
+/*
+* Waits until a file descriptor has input, or scheduled commands come due
+* (the caller runs them with runDueTimers(), after making room for anything they print)
+* fd: the file descriptor
+* return: 1 if fd has input; 0 if scheduled commands are due; -1 if a signal interrupted
+*/
+int waitForInputOrTimer(int fd) {
+    struct pollfd pollFDs[2] = {
+        {.fd = fd, .events = POLLIN},
+        {.fd = GLOBAL_timerWheel.timerFD, .events = POLLIN}
+    };
+
+    // with nothing scheduled, the caller can just block in read()
+    if (GLOBAL_timerWheel.timerCount == 0) {
+        return 1;
+    }
+
+    if (poll(pollFDs, 2, -1) == -1) {
+        return -1;
+    }
+
+    return (pollFDs[1].revents & POLLIN) ? 0 : 1;
+}
+
+
+/*
+* Gets the timerfd that becomes readable when scheduled commands come due, so a
+* builtin that blocks can poll it too and call runDueTimers() when it fires
+* return: the timerfd, or -1 if nothing has been scheduled yet (poll() skips it)
+*/
+int getTimerFD() {
+    return GLOBAL_timerWheel.timerFD;
+}
+
+
+/*
+* Waits for a foreground child to end, running scheduled commands as they come due
+* pid: the child's PID
+* childStatus: set to the child's status from waitpid()
+* return: the child's PID, or -1 on failure (like waitpid())
+*/
+pid_t waitForForegroundChild(pid_t pid, int* childStatus) {
+    int pidFD = GLOBAL_timerWheel.timerCount > 0 ? openPidfd(pid) : -1;
+
+    if (pidFD != -1) {
+        struct pollfd pollFDs[2] = {
+            {.fd = pidFD, .events = POLLIN},
+            {.fd = GLOBAL_timerWheel.timerFD, .events = POLLIN}
+        };
+
+        // sleep until the child ends, waking up to run timers
+        while (!(pollFDs[0].revents & POLLIN)) {
+            if (poll(pollFDs, 2, -1) == -1) {
+                continue;
+            }
+
+            if (pollFDs[1].revents & POLLIN) {
+                runDueTimers();
+            }
+        }
+
+        close(pidFD);
+    }
+
+    pid_t waitResult;
+
+    while ((waitResult = waitpid(pid, childStatus, 0)) == -1 && errno == EINTR) {
+    }
+
+    return waitResult;
+}
+
+
+/*
+* Parses a time like 500ms, 30s, 5m, 2h, or 1.5 (seconds, if there's no unit)
+* text: the time
+* return: the time in wheel ticks (at least 1), or -1 if it isn't a time
+*/
+static long long parseTicks(char* text) {
+    char* unit;
+    double milliseconds = strtod(text, &unit);
+
+    if (unit == text || milliseconds < 0) {
+        return -1;
+    }
+
+    if (isEqualString(unit, "ms")) {
+        // already milliseconds
+    } else if (*unit == '\0' || isEqualString(unit, "s")) {
+        milliseconds *= 1000;
+    } else if (isEqualString(unit, "m")) {
+        milliseconds *= 60 * 1000;
+    } else if (isEqualString(unit, "h")) {
+        milliseconds *= 60 * 60 * 1000;
+    } else {
+        return -1;
+    }
+
+    long long ticks = (milliseconds + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+
+    return ticks > 0 ? ticks : 1;
+}
+
+
+/*
+* Makes the command a scheduling builtin runs out of its own CommandLine:
+* the args after the time become the command and its args, and it gets a copy
+* of the builtin's redirections
+* commandLine: the every or at command line (left unchanged, since a loop runs it again)
+* return: the command to schedule
+*/
+static struct CommandLine* takeScheduledCommand(struct CommandLine* commandLine) {
+    struct CommandLine* scheduled = calloc(1, sizeof(struct CommandLine));
+
+    // the command and its args
+    scheduled->command = strdup(commandLine->args[1]);
+    scheduled->args = calloc(MAX_ARG_COUNT, sizeof(char*));
+
+    for (int index = 2; index < commandLine->argCount; ++index) {
+        scheduled->args[scheduled->argCount] = strdup(commandLine->args[index]);
+        ++scheduled->argCount;
+    }
+
+    // the redirections
+    scheduled->inFile = commandLine->inFile ? strdup(commandLine->inFile) : NULL;
+    scheduled->outFile = commandLine->outFile ? strdup(commandLine->outFile) : NULL;
+    scheduled->errFile = commandLine->errFile ? strdup(commandLine->errFile) : NULL;
+    scheduled->isInFileWritable = commandLine->isInFileWritable;
+    scheduled->isOutAppend = commandLine->isOutAppend;
+    scheduled->isErrAppend = commandLine->isErrAppend;
+    scheduled->isErrToOut = commandLine->isErrToOut;
+
+    if (commandLine->hereDocument) {
+        scheduled->hereDocument = malloc(commandLine->hereDocumentLength + 1);
+        memcpy(scheduled->hereDocument, commandLine->hereDocument, commandLine->hereDocumentLength + 1);
+        scheduled->hereDocumentLength = commandLine->hereDocumentLength;
+    }
+
+    if (commandLine->teeFileCount > 0) {
+        scheduled->teeFiles = calloc(commandLine->teeFileCount, sizeof(char*));
+
+        for (int index = 0; index < commandLine->teeFileCount; ++index) {
+            scheduled->teeFiles[index] = strdup(commandLine->teeFiles[index]);
+        }
+
+        scheduled->teeFileCount = commandLine->teeFileCount;
+    }
+
+    // scheduled commands always run in the background
+    scheduled->isBackground = true;
+
+    return scheduled;
+}
+
+
+/*
+* Adds a timer for the command in an every or at command line
+* commandLine: the every or at command line
+* intervalTicks: ticks between runs for every; 0 for at
+* delayTicks: ticks until the first run
+*/
+static void scheduleCommand(struct CommandLine* commandLine, long long intervalTicks, long long delayTicks) {
+    struct ScheduledTimer* timer = calloc(1, sizeof(struct ScheduledTimer));
+
+    // the wheel's clock and timerfd start with the first timer
+    if (GLOBAL_timerWheel.timerFD == -1) {
+        GLOBAL_timerWheel.timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        clock_gettime(CLOCK_MONOTONIC, &GLOBAL_timerWheel.startTime);
+    }
+
+    // remember the command as typed, for the timers command
+    size_t length = 1;
+
+    for (int index = 1; index < commandLine->argCount; ++index) {
+        length += strlen(commandLine->args[index]) + 1;
+    }
+
+    timer->commandString = calloc(length, sizeof(char));
+
+    for (int index = 1; index < commandLine->argCount; ++index) {
+        strcat(timer->commandString, commandLine->args[index]);
+        strcat(timer->commandString, index + 1 < commandLine->argCount ? " " : "");
+    }
+
+    timer->commandLine = takeScheduledCommand(commandLine);
+    timer->intervalTicks = intervalTicks;
+    timer->expiryTick = getCurrentTick() + delayTicks;
+
+    // give it an id
+    if (GLOBAL_timerWheel.nextId >= GLOBAL_timerWheel.idCapacity) {
+        GLOBAL_timerWheel.idCapacity = GLOBAL_timerWheel.idCapacity ? GLOBAL_timerWheel.idCapacity * 2 : 64;
+        GLOBAL_timerWheel.timersById = realloc(GLOBAL_timerWheel.timersById,
+                                               GLOBAL_timerWheel.idCapacity * sizeof(struct ScheduledTimer*));
+    }
+
+    timer->id = GLOBAL_timerWheel.nextId;
+    GLOBAL_timerWheel.timersById[timer->id] = timer;
+    ++GLOBAL_timerWheel.nextId;
+    ++GLOBAL_timerWheel.timerCount;
+
+    insertTimer(timer);
+    armTimerFD();
+
+    printf("timer %d scheduled\n", timer->id);
+    fflush(NULL);
+
+    return;
+}
+
+
+/*
+* Runs a command in the background every so often
+* every INTERVAL command [arg...]
+* The first run is one interval from now
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleEveryCommand(struct CommandLine* commandLine) {
+    long long intervalTicks = commandLine->argCount >= 2 ? parseTicks(commandLine->args[0]) : -1;
+
+    if (intervalTicks == -1) {
+        printToTerminal("usage: every INTERVAL command [arg...]  (like 500ms, 30s, 5m, or 2h)\n", false);
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    scheduleCommand(commandLine, intervalTicks, intervalTicks);
+    GLOBAL_lastForegroundChildStatus = 0;
+
+    return;
+}
+
+
+/*
+* Runs a command in the background once, after a delay
+* at DELAY command [arg...]
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleAtCommand(struct CommandLine* commandLine) {
+    long long delayTicks = commandLine->argCount >= 2 ? parseTicks(commandLine->args[0]) : -1;
+
+    if (delayTicks == -1) {
+        printToTerminal("usage: at DELAY command [arg...]  (like 500ms, 30s, 5m, or 2h)\n", false);
+        GLOBAL_lastForegroundChildStatus = 1;
+        return;
+    }
+
+    scheduleCommand(commandLine, 0, delayTicks);
+    GLOBAL_lastForegroundChildStatus = 0;
+
+    return;
+}
+
+
+/*
+* Lists the scheduled commands, with how long until each runs next
+*/
+void handleTimersCommand() {
+    long long currentTick = getCurrentTick();
+
+    for (int id = 1; id < GLOBAL_timerWheel.nextId; ++id) {
+        struct ScheduledTimer* timer = GLOBAL_timerWheel.timersById[id];
+
+        if (!timer) {
+            continue;
+        }
+
+        long long remainingTicks = timer->expiryTick > currentTick ? timer->expiryTick - currentTick : 0;
+
+        if (timer->intervalTicks > 0) {
+            printf("%d  every %.2fs  next in %.2fs  %s\n", id, timer->intervalTicks * TIMER_TICK_MS / 1000.0,
+                   remainingTicks * TIMER_TICK_MS / 1000.0, timer->commandString);
+        } else {
+            printf("%d  at  in %.2fs  %s\n", id, remainingTicks * TIMER_TICK_MS / 1000.0, timer->commandString);
+        }
+    }
+
+    fflush(NULL);
+
+    return;
+}
+
+
+/*
+* Cancels scheduled commands
+* cancel ID...
+* commandLine: pointer to a CommandLine struct which has the command line's details
+*/
+void handleCancelCommand(struct CommandLine* commandLine) {
+    GLOBAL_lastForegroundChildStatus = 0;
+
+    for (int index = 0; index < commandLine->argCount; ++index) {
+        int id = atoi(commandLine->args[index]);
+
+        if (id <= 0 || id >= GLOBAL_timerWheel.nextId || !GLOBAL_timerWheel.timersById[id]) {
+            fprintf(stderr, "cancel: no timer %s\n", commandLine->args[index]);
+            fflush(stderr);
+            GLOBAL_lastForegroundChildStatus = 1;
+            continue;
+        }
+
+        struct ScheduledTimer* timer = GLOBAL_timerWheel.timersById[id];
+
+        if (!timer->previousNext) {
+            // This is the timer whose command is running (this cancel), so it's out of
+            // the wheel, and its command line is in use. advanceTick() frees it afterward
+            timer->isCancelled = true;
+        } else {
+            unlinkTimer(timer);
+            freeTimer(timer);
+        }
+    }
+
+    if (GLOBAL_timerWheel.timerFD != -1) {
+        armTimerFD();
+    }
+
+    return;
+}